@@ -0,0 +1,75 @@
+#include "serialization.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// Measures loading a base written by make_base: the catalogue, which BaseFile reads at once,
+// and the router, which it reads on first use, with the base on the heap and on an arena.
+// Usage: base_benchmark BASE [RUNS] [THREADS]
+
+using namespace std;
+
+namespace {
+	struct Timings
+	{
+		double catalogue_ms = numeric_limits<double>::max();
+		double router_ms = numeric_limits<double>::max();
+	};
+
+	double ToMilliseconds(chrono::steady_clock::duration duration)
+	{
+		return chrono::duration<double, milli>(duration).count();
+	}
+
+	// the best of runs loads, each into a new catalogue, as process_requests loads the base;
+	// the arena is the one --arena uses, created and torn down with every load
+	Timings Measure(const string& filename, size_t runs, size_t thread_count, bool use_arena)
+	{
+		Timings best;
+		for (size_t i = 0; i < runs; i++)
+		{
+			std::pmr::monotonic_buffer_resource arena;
+			std::pmr::memory_resource* resource = use_arena ? &arena : std::pmr::get_default_resource();
+			TransportCatalogue catalogue(resource);
+
+			const auto start = chrono::steady_clock::now();
+			serialization::BaseFile base(filename, catalogue, resource, thread_count);
+			const auto loaded = chrono::steady_clock::now();
+			base.GetRouter();
+			const auto routed = chrono::steady_clock::now();
+
+			best.catalogue_ms = min(best.catalogue_ms, ToMilliseconds(loaded - start));
+			best.router_ms = min(best.router_ms, ToMilliseconds(routed - loaded));
+		}
+		return best;
+	}
+
+	void Report(std::string_view name, const Timings& timings)
+	{
+		cout << name << ": catalogue "sv << timings.catalogue_ms << " ms, router "sv << timings.router_ms << " ms\n"sv;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "Usage: base_benchmark BASE [RUNS] [THREADS]\n"sv;
+		return 1;
+	}
+	const string filename = argv[1];
+	const size_t runs = max<size_t>(argc > 2 ? stoul(argv[2]) : 200, 1);
+	const size_t thread_count = max<size_t>(argc > 3 ? stoul(argv[3]) : 1, 1);
+
+	cout.precision(3);
+	cout << fixed;
+	Report("heap"sv, Measure(filename, runs, thread_count, false));
+	Report("arena"sv, Measure(filename, runs, thread_count, true));
+	return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace Transport {
+
+	// Passes allocations to the upstream resource and counts the bytes requested from it.
+	// Placed under a monotonic_buffer_resource, it measures the memory taken by a whole base.
+	class CountingResource : public std::pmr::memory_resource
+	{
+	public:
+		explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: upstream_(upstream) {}
+
+		// bytes currently allocated
+		size_t GetAllocatedBytes() const {
+			return allocated_;
+		}
+
+		// maximum of GetAllocatedBytes() over the lifetime of the resource
+		size_t GetPeakBytes() const {
+			return peak_;
+		}
+
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			void* p = upstream_->allocate(bytes, alignment);
+			allocated_ += bytes;
+			if (allocated_ > peak_)
+			{
+				peak_ = allocated_;
+			}
+			return p;
+		}
+
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+			upstream_->deallocate(p, bytes, alignment);
+			allocated_ -= bytes;
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+
+	private:
+		std::pmr::memory_resource* upstream_;
+		size_t allocated_ = 0;
+		size_t peak_ = 0;
+	};
+}
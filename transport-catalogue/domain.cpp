@@ -52,14 +52,14 @@ ostream& Transport::operator<<(ostream& out, const StopInfo& info)
 	{
 		out << "not found"s;
 	}
-	else if (!info.buses)
+	else if (info.buses.empty())
 	{
 		out << "no buses"s;
 	}
 	else
 	{
 		out << "buses"s;
-		for (const auto bus_ptr : *(info.buses)) {
+		for (const auto bus_ptr : info.buses) {
 			out << ' ' << bus_ptr->name;
 		}
 	}
@@ -1,18 +1,23 @@
 #pragma once
 
 #include "geo.h"
+#include "ranges.h"
 
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
 
 namespace Transport {
 
 	struct Stop
 	{
-		std::string name;
+		// owned by the catalogue's name arena
+		std::string_view name;
 		Geo::Coordinates coords;
+		// index of the stop in the catalogue
+		size_t id = 0;
 
 		friend std::ostream& operator<<(std::ostream& out, const Stop& stop);
 		bool operator==(const Stop& other) const;
@@ -20,27 +25,39 @@ namespace Transport {
 
 	struct Bus
 	{
-		std::string name;
-		std::vector<const Stop*> stops;
+		// owned by the catalogue's name arena
+		std::string_view name;
+		// allocated from the catalogue's memory resource
+		std::pmr::vector<const Stop*> stops;
 		bool is_roundtrip = true;
+		// index of the bus in the catalogue
+		size_t id = 0;
 
 		friend std::ostream& operator<<(std::ostream& out, const Bus& bus);
 	};
 
-	struct BusComparator;
+	// view of the buses passing through a stop, sorted by bus name
+	using BusesView = ranges::Range<const Bus* const*>;
+
+	struct NearbyStop
+	{
+		const Stop* stop = nullptr;
+		// meters
+		double distance = 0.;
+	};
 
 	struct StopInfo
 	{
-		std::string name;
+		std::string_view name;
 		bool exists = false;
-		const std::set<const Bus*, BusComparator>* buses = nullptr;
+		BusesView buses;
 
 		friend std::ostream& operator<<(std::ostream& out, const StopInfo& info);
 	};
 
 	struct BusInfo
 	{
-		std::string name;
+		std::string_view name;
 		bool exists = false;
 		size_t stops_count = 0;
 		size_t unique_stops = 0;
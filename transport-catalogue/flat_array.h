@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Transport {
+
+	// Array of plain elements which are either owned or stored elsewhere, e.g. in a mapped base file
+	// that must outlive the array. Either way they lie in one block, so the array can be written
+	// to a file as is and used in place after the file is mapped back.
+	template <typename T>
+	class FlatArray
+	{
+	public:
+		FlatArray() = default;
+
+		explicit FlatArray(std::pmr::vector<T> elements)
+			: owned_(std::move(elements)), size_(owned_.size()) {}
+
+		// refers to size elements at data without copying them
+		FlatArray(const T* data, size_t size)
+			: external_(data), size_(size) {}
+
+		const T* data() const {
+			// the owned block moves together with the array, so the pointer is not kept
+			return external_ ? external_ : owned_.data();
+		}
+
+		size_t size() const {
+			return size_;
+		}
+
+		bool empty() const {
+			return size_ == 0;
+		}
+
+		const T& operator[](size_t index) const {
+			return data()[index];
+		}
+
+		const T& at(size_t index) const {
+			if (index >= size_)
+			{
+				throw std::out_of_range("FlatArray index is out of range");
+			}
+			return data()[index];
+		}
+
+		const T* begin() const {
+			return data();
+		}
+
+		const T* end() const {
+			return data() + size_;
+		}
+
+	private:
+		std::pmr::vector<T> owned_;
+		const T* external_ = nullptr;
+		size_t size_ = 0;
+	};
+}
@@ -0,0 +1,563 @@
+#include "flat_base.h"
+#include "serialization.h"
+#include "flat_array.h"
+#include "route_matrix.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	// the name of the format and its version
+	constexpr char MAGIC[serialization::FLAT_BASE_MAGIC_SIZE] = { 'T', 'C', 'F', 'L', 'A', 'T', '0', '1' };
+	// reads differently on a host with another byte order
+	constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+	constexpr size_t SECTION_ALIGNMENT = 8;
+
+	enum class SectionKind : uint32_t
+	{
+		NAMES,
+		STOPS,
+		BUSES,
+		BUS_STOPS,
+		DISTANCES,
+		STOP_BUSES_OFFSETS,
+		STOP_BUSES,
+		STOP_NAME_SEEDS,
+		STOP_NAME_IDS,
+		STOP_NAME_FINGERPRINTS,
+		BUS_NAME_SEEDS,
+		BUS_NAME_IDS,
+		BUS_NAME_FINGERPRINTS,
+		SPATIAL_GRID,
+		SPATIAL_CELL_OFFSETS,
+		SPATIAL_IDS,
+		STOP_SEARCH_ORDER,
+		BUS_SEARCH_ORDER,
+		RENDER_SETTINGS,
+		ROUTER_SETTINGS,
+		EDGES,
+		ROUTES,
+		MAP_SVG,
+		MAP_JSON,
+		// the salts of the stop and the bus name indexes, empty in older bases
+		NAME_SALTS,
+		COUNT
+	};
+
+	constexpr size_t SECTION_COUNT = static_cast<size_t>(SectionKind::COUNT);
+
+	// followed by a Section for each kind
+	struct Header
+	{
+		char magic[sizeof(MAGIC)];
+		uint32_t byte_order;
+		uint32_t section_count;
+	};
+
+	// bytes [offset, offset + size) of the file
+	struct Section
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// the name is a slice of the NAMES section
+	struct FlatStop
+	{
+		double lat;
+		double lng;
+		uint32_t name_offset;
+		uint32_t name_size;
+	};
+
+	// the stops are BUS_STOPS[stops_offset] .. BUS_STOPS[stops_offset + stops_count - 1]
+	struct FlatBus
+	{
+		uint32_t name_offset;
+		uint32_t name_size;
+		uint32_t stops_offset;
+		uint32_t stops_count;
+		uint32_t is_roundtrip;
+	};
+
+	struct FlatDistance
+	{
+		uint32_t from;
+		uint32_t to;
+		int32_t distance;
+	};
+
+	struct FlatGrid
+	{
+		double min_lat;
+		double min_lng;
+		double cell_lat;
+		double cell_lng;
+		uint64_t rows;
+		uint64_t cols;
+	};
+
+	struct FlatRouterSettings
+	{
+		int32_t bus_wait_time;
+		int32_t bus_velocity;
+		double walking_velocity;
+		double walking_distance;
+		uint64_t vertex_count;
+	};
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			throw invalid_argument("Malformed flat base: "s + what);
+		}
+	}
+
+	// writes the sections one after another and the table of them on Finish()
+	class FlatWriter
+	{
+	public:
+		explicit FlatWriter(const string& filename)
+			: filename_(filename), out_(filename, ios::binary)
+		{
+			// the header and the table are rewritten once the sections are known
+			const vector<char> zeros(sizeof(Header) + sizeof(Section) * SECTION_COUNT, 0);
+			Append(zeros.data(), zeros.size());
+		}
+
+		template <typename T>
+		void WriteSection(SectionKind kind, const T* data, size_t count)
+		{
+			BeginSection(kind);
+			Append(data, count);
+			EndSection();
+		}
+
+		template <typename Container>
+		void WriteSection(SectionKind kind, const Container& elements)
+		{
+			WriteSection(kind, elements.data(), elements.size());
+		}
+
+		void BeginSection(SectionKind kind)
+		{
+			static const char zeros[SECTION_ALIGNMENT] = {};
+			Append(zeros, (SECTION_ALIGNMENT - position_ % SECTION_ALIGNMENT) % SECTION_ALIGNMENT);
+			current_ = &sections_[static_cast<size_t>(kind)];
+			current_->offset = position_;
+		}
+
+		template <typename T>
+		void Append(const T* data, size_t count)
+		{
+			static_assert(is_trivially_copyable_v<T>);
+			out_.write(reinterpret_cast<const char*>(data), sizeof(T) * count);
+			position_ += sizeof(T) * count;
+		}
+
+		void EndSection()
+		{
+			current_->size = position_ - current_->offset;
+		}
+
+		// throws std::runtime_error if the file can't be written
+		void Finish()
+		{
+			Header header;
+			memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.byte_order = BYTE_ORDER_MARK;
+			header.section_count = SECTION_COUNT;
+			out_.seekp(0);
+			out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out_.write(reinterpret_cast<const char*>(sections_.data()), sizeof(Section) * SECTION_COUNT);
+			out_.flush();
+			if (!out_)
+			{
+				throw runtime_error("Can't write the base to "s + filename_);
+			}
+		}
+
+	private:
+		string filename_;
+		ofstream out_;
+		uint64_t position_ = 0;
+		array<Section, SECTION_COUNT> sections_ = {};
+		Section* current_ = nullptr;
+	};
+
+	// the sections of a flat base in memory
+	class FlatReader
+	{
+	public:
+		explicit FlatReader(string_view data)
+			: data_(data)
+		{
+			Expect(serialization::IsFlatBase(data_), "no header");
+			Header header;
+			memcpy(&header, data_.data(), sizeof(header));
+			if (header.byte_order != BYTE_ORDER_MARK)
+			{
+				throw invalid_argument("The flat base was written on a host with another byte order");
+			}
+			// the table of an older base ends before the kinds added later, their sections are empty
+			Expect(header.section_count <= SECTION_COUNT
+				&& data_.size() >= sizeof(Header) + sizeof(Section) * header.section_count, "section table");
+			memcpy(sections_.data(), data_.data() + sizeof(Header), sizeof(Section) * header.section_count);
+		}
+
+		string_view GetBytes(SectionKind kind) const
+		{
+			const auto& section = sections_[static_cast<size_t>(kind)];
+			Expect(section.offset <= data_.size() && section.size <= data_.size() - section.offset, "section bounds");
+			return data_.substr(section.offset, section.size);
+		}
+
+		// the elements of the section in place
+		template <typename T>
+		FlatArray<T> Get(SectionKind kind) const
+		{
+			static_assert(is_trivially_copyable_v<T>);
+			const auto bytes = GetBytes(kind);
+			Expect(bytes.size() % sizeof(T) == 0 && reinterpret_cast<uintptr_t>(bytes.data()) % alignof(T) == 0,
+				"section layout");
+			return { reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T) };
+		}
+
+	private:
+		string_view data_;
+		array<Section, SECTION_COUNT> sections_ = {};
+	};
+
+	string_view GetName(string_view names, uint32_t offset, uint32_t size)
+	{
+		Expect(offset <= names.size() && size <= names.size() - offset, "name bounds");
+		return names.substr(offset, size);
+	}
+
+	const Stop* GetStop(const TransportCatalogue& catalogue, uint32_t id)
+	{
+		const Stop* stop = catalogue.GetStopById(id);
+		Expect(stop, "stop id");
+		return stop;
+	}
+
+	const Bus* GetBus(const TransportCatalogue& catalogue, uint32_t id)
+	{
+		const Bus* bus = catalogue.GetBusById(id);
+		Expect(bus, "bus id");
+		return bus;
+	}
+
+	template <typename T>
+	vector<T> ToVector(const FlatArray<T>& elements)
+	{
+		return { elements.begin(), elements.end() };
+	}
+
+	void WriteNameIndex(FlatWriter& writer, const PerfectHash& index, SectionKind seeds, SectionKind ids, SectionKind fingerprints)
+	{
+		writer.WriteSection(seeds, index.GetSeeds());
+		writer.WriteSection(ids, index.GetIds());
+		writer.WriteSection(fingerprints, index.GetFingerprints());
+	}
+
+	// the edges with their info and the routes between all the vertices
+	void WriteRouter(FlatWriter& writer, const TransportCatalogue& catalogue, const Routing::RouterSettings& router_settings)
+	{
+		const Routing::TransportRouter router(catalogue, router_settings, catalogue.GetMemoryResource());
+		const auto& graph = router.GetGraph();
+
+		const FlatRouterSettings settings{ router_settings.bus_wait_time, router_settings.bus_velocity,
+			router_settings.walking_velocity, router_settings.walking_distance, graph.GetVertexCount() };
+		writer.WriteSection(SectionKind::ROUTER_SETTINGS, &settings, 1);
+
+		writer.WriteSection(SectionKind::EDGES, router.GetRouteEdges());
+
+		// row by row, so the matrix is not copied as a whole
+		vector<Routing::RouteMatrix::Cell> row;
+		writer.BeginSection(SectionKind::ROUTES);
+		for (const auto& routes : router.GetRouter().GetRoutesInternalData()) {
+			row.clear();
+			for (const auto& route : routes) {
+				row.push_back(Routing::RouteMatrix::MakeCell(route));
+			}
+			writer.Append(row.data(), row.size());
+		}
+		writer.EndSection();
+	}
+
+	void ReadStops(const FlatReader& reader, TransportCatalogue& catalogue)
+	{
+		const auto names = reader.GetBytes(SectionKind::NAMES);
+		std::pmr::deque<Stop> stops(catalogue.GetMemoryResource());
+		for (const auto& flat_stop : reader.Get<FlatStop>(SectionKind::STOPS)) {
+			Stop stop;
+			stop.name = GetName(names, flat_stop.name_offset, flat_stop.name_size);
+			stop.coords.lat = flat_stop.lat;
+			stop.coords.lng = flat_stop.lng;
+			stops.push_back(stop);
+		}
+		catalogue.SetStops(std::move(stops));
+	}
+
+	void ReadBuses(const FlatReader& reader, TransportCatalogue& catalogue)
+	{
+		const auto names = reader.GetBytes(SectionKind::NAMES);
+		const auto bus_stops = reader.Get<uint32_t>(SectionKind::BUS_STOPS);
+		std::pmr::deque<Bus> buses(catalogue.GetMemoryResource());
+		for (const auto& flat_bus : reader.Get<FlatBus>(SectionKind::BUSES)) {
+			Expect(flat_bus.stops_offset <= bus_stops.size() && flat_bus.stops_count <= bus_stops.size() - flat_bus.stops_offset,
+				"bus stops bounds");
+			// moving a pmr vector keeps its resource, so the stop list is created with the catalogue's one
+			Bus bus{ GetName(names, flat_bus.name_offset, flat_bus.name_size),
+				std::pmr::vector<const Stop*>(catalogue.GetMemoryResource()) };
+			bus.is_roundtrip = flat_bus.is_roundtrip != 0;
+			bus.stops.reserve(flat_bus.stops_count);
+			for (size_t i = 0; i < flat_bus.stops_count; i++)
+			{
+				bus.stops.push_back(GetStop(catalogue, bus_stops[flat_bus.stops_offset + i]));
+			}
+			buses.push_back(std::move(bus));
+		}
+		catalogue.SetBuses(std::move(buses));
+	}
+
+	void ReadDistances(const FlatReader& reader, TransportCatalogue& catalogue)
+	{
+		const auto distances = reader.Get<FlatDistance>(SectionKind::DISTANCES);
+		TransportCatalogue::DistanceMap distance_map(catalogue.GetMemoryResource());
+		distance_map.reserve(distances.size());
+		for (const auto& distance : distances) {
+			distance_map[{ GetStop(catalogue, distance.from), GetStop(catalogue, distance.to) }] = distance.distance;
+		}
+		catalogue.SetDistanceMap(std::move(distance_map));
+	}
+
+	void ReadStopToBuses(const FlatReader& reader, TransportCatalogue& catalogue)
+	{
+		const auto offsets = reader.Get<uint32_t>(SectionKind::STOP_BUSES_OFFSETS);
+		const auto bus_ids = reader.Get<uint32_t>(SectionKind::STOP_BUSES);
+		Expect(offsets.size() == catalogue.GetStopsCount() + 1 && offsets[0] == 0
+			&& offsets[offsets.size() - 1] == bus_ids.size() && is_sorted(offsets.begin(), offsets.end()), "stop buses offsets");
+
+		TransportCatalogue::StopToBusesIndex index{
+			std::pmr::vector<size_t>(offsets.begin(), offsets.end(), catalogue.GetMemoryResource()),
+			std::pmr::vector<const Bus*>(catalogue.GetMemoryResource()) };
+		index.buses.reserve(bus_ids.size());
+		for (const auto id : bus_ids) {
+			index.buses.push_back(GetBus(catalogue, id));
+		}
+		catalogue.SetStopToBuses(std::move(index));
+	}
+
+	PerfectHash ReadNameIndex(const FlatReader& reader, SectionKind seeds, SectionKind ids, SectionKind fingerprints,
+		size_t names_count, uint32_t salt)
+	{
+		auto name_ids = ToVector(reader.Get<uint32_t>(ids));
+		auto name_seeds = ToVector(reader.Get<uint32_t>(seeds));
+		auto name_fingerprints = ToVector(reader.Get<uint32_t>(fingerprints));
+		// the catalogue looks the found id up without checking it
+		Expect(all_of(name_ids.begin(), name_ids.end(), [names_count](uint32_t id) { return id < names_count; }), "name index");
+		// the hash takes a bucket modulo the seeds and a slot modulo the ids
+		Expect(name_fingerprints.size() == name_ids.size() && name_seeds.empty() == name_ids.empty(), "name index size");
+		return PerfectHash(std::move(name_seeds), std::move(name_ids), std::move(name_fingerprints), salt);
+	}
+
+	void ReadIndexes(const FlatReader& reader, TransportCatalogue& catalogue)
+	{
+		const size_t stops_count = catalogue.GetStopsCount();
+		const size_t buses_count = catalogue.GetBuses().size();
+		const auto salts = reader.Get<uint32_t>(SectionKind::NAME_SALTS);
+		Expect(salts.size() == 0 || salts.size() == 2, "name salts");
+		catalogue.SetNameIndexes(
+			ReadNameIndex(reader, SectionKind::STOP_NAME_SEEDS, SectionKind::STOP_NAME_IDS, SectionKind::STOP_NAME_FINGERPRINTS, stops_count,
+				salts.size() != 0 ? salts[0] : 0),
+			ReadNameIndex(reader, SectionKind::BUS_NAME_SEEDS, SectionKind::BUS_NAME_IDS, SectionKind::BUS_NAME_FINGERPRINTS, buses_count,
+				salts.size() != 0 ? salts[1] : 0));
+
+		const auto grids = reader.Get<FlatGrid>(SectionKind::SPATIAL_GRID);
+		auto cell_offsets = ToVector(reader.Get<uint32_t>(SectionKind::SPATIAL_CELL_OFFSETS));
+		auto spatial_ids = ToVector(reader.Get<uint32_t>(SectionKind::SPATIAL_IDS));
+		Expect(grids.size() == 1 && grids[0].rows > 0 && grids[0].cols > 0
+			&& grids[0].rows <= cell_offsets.size() && grids[0].cols <= cell_offsets.size()
+			&& cell_offsets.size() == grids[0].rows * grids[0].cols + 1
+			&& isfinite(grids[0].min_lat) && isfinite(grids[0].min_lng)
+			&& isfinite(grids[0].cell_lat) && grids[0].cell_lat > 0 && isfinite(grids[0].cell_lng) && grids[0].cell_lng > 0,
+			"spatial grid");
+		Expect(cell_offsets[0] == 0 && cell_offsets[cell_offsets.size() - 1] == spatial_ids.size()
+			&& is_sorted(cell_offsets.begin(), cell_offsets.end()), "spatial cell offsets");
+		Expect(all_of(spatial_ids.begin(), spatial_ids.end(), [stops_count](uint32_t id) { return id < stops_count; }),
+			"spatial ids");
+		SpatialIndex::Grid grid;
+		grid.min_lat = grids[0].min_lat;
+		grid.min_lng = grids[0].min_lng;
+		grid.cell_lat = grids[0].cell_lat;
+		grid.cell_lng = grids[0].cell_lng;
+		grid.rows = grids[0].rows;
+		grid.cols = grids[0].cols;
+
+		vector<Geo::Coordinates> points;
+		vector<string_view> stop_names;
+		points.reserve(stops_count);
+		stop_names.reserve(stops_count);
+		for (const auto stop : catalogue.GetStops()) {
+			points.push_back(stop->coords);
+			stop_names.push_back(stop->name);
+		}
+		catalogue.SetSpatialIndex(SpatialIndex(grid, std::move(cell_offsets), std::move(spatial_ids), points));
+
+		vector<string_view> bus_names;
+		bus_names.reserve(buses_count);
+		for (const auto& bus : catalogue.GetBuses()) {
+			bus_names.push_back(bus.name);
+		}
+		catalogue.SetSearchIndexes(
+			NameSearchIndex(stop_names, ToVector(reader.Get<uint32_t>(SectionKind::STOP_SEARCH_ORDER))),
+			NameSearchIndex(bus_names, ToVector(reader.Get<uint32_t>(SectionKind::BUS_SEARCH_ORDER))));
+	}
+}
+
+void serialization::SerializeFlatBase(const Transport::TransportCatalogue& catalogue, const std::string& filename,
+	const Transport::Rendering::RenderSettings& render_settings,
+	const Transport::Routing::RouterSettings& router_settings)
+{
+	FlatWriter writer(filename);
+
+	// stop ids are positions in the catalogue, so they need no mapping
+	string names;
+	vector<FlatStop> stops;
+	stops.reserve(catalogue.GetStopsCount());
+	for (const auto stop : catalogue.GetStops()) {
+		stops.push_back({ stop->coords.lat, stop->coords.lng,
+			static_cast<uint32_t>(names.size()), static_cast<uint32_t>(stop->name.size()) });
+		names += stop->name;
+	}
+
+	vector<FlatBus> buses;
+	vector<uint32_t> bus_stops;
+	buses.reserve(catalogue.GetBuses().size());
+	for (const auto& bus : catalogue.GetBuses()) {
+		buses.push_back({ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(bus.name.size()),
+			static_cast<uint32_t>(bus_stops.size()), static_cast<uint32_t>(bus.stops.size()), bus.is_roundtrip });
+		names += bus.name;
+		for (const auto stop : bus.stops) {
+			bus_stops.push_back(static_cast<uint32_t>(stop->id));
+		}
+	}
+
+	writer.WriteSection(SectionKind::NAMES, names);
+	writer.WriteSection(SectionKind::STOPS, stops);
+	writer.WriteSection(SectionKind::BUSES, buses);
+	writer.WriteSection(SectionKind::BUS_STOPS, bus_stops);
+
+	vector<FlatDistance> distances;
+	distances.reserve(catalogue.GetDistanceMap().size());
+	for (const auto& [stops, distance] : catalogue.GetDistanceMap()) {
+		distances.push_back({ static_cast<uint32_t>(stops.first->id), static_cast<uint32_t>(stops.second->id), distance });
+	}
+	writer.WriteSection(SectionKind::DISTANCES, distances);
+
+	vector<uint32_t> stop_bus_offsets{ 0 };
+	vector<uint32_t> stop_buses;
+	for (const auto stop : catalogue.GetStops()) {
+		for (const auto bus : catalogue.GetStopToBuses(stop)) {
+			stop_buses.push_back(static_cast<uint32_t>(bus->id));
+		}
+		stop_bus_offsets.push_back(static_cast<uint32_t>(stop_buses.size()));
+	}
+	writer.WriteSection(SectionKind::STOP_BUSES_OFFSETS, stop_bus_offsets);
+	writer.WriteSection(SectionKind::STOP_BUSES, stop_buses);
+
+	WriteNameIndex(writer, catalogue.GetStopNameIndex(),
+		SectionKind::STOP_NAME_SEEDS, SectionKind::STOP_NAME_IDS, SectionKind::STOP_NAME_FINGERPRINTS);
+	WriteNameIndex(writer, catalogue.GetBusNameIndex(),
+		SectionKind::BUS_NAME_SEEDS, SectionKind::BUS_NAME_IDS, SectionKind::BUS_NAME_FINGERPRINTS);
+	const array<uint32_t, 2> salts{ catalogue.GetStopNameIndex().GetSalt(), catalogue.GetBusNameIndex().GetSalt() };
+	writer.WriteSection(SectionKind::NAME_SALTS, salts);
+
+	const auto& spatial_index = catalogue.GetSpatialIndex();
+	const auto& grid = spatial_index.GetGrid();
+	const FlatGrid flat_grid{ grid.min_lat, grid.min_lng, grid.cell_lat, grid.cell_lng, grid.rows, grid.cols };
+	writer.WriteSection(SectionKind::SPATIAL_GRID, &flat_grid, 1);
+	writer.WriteSection(SectionKind::SPATIAL_CELL_OFFSETS, spatial_index.GetCellOffsets());
+	writer.WriteSection(SectionKind::SPATIAL_IDS, spatial_index.GetIds());
+
+	writer.WriteSection(SectionKind::STOP_SEARCH_ORDER, catalogue.GetStopSearchIndex().GetOrder());
+	writer.WriteSection(SectionKind::BUS_SEARCH_ORDER, catalogue.GetBusSearchIndex().GetOrder());
+
+	writer.WriteSection(SectionKind::RENDER_SETTINGS, SerializeRenderSettings(render_settings));
+	{
+		const auto map = Rendering::RenderMap(catalogue, render_settings);
+		writer.WriteSection(SectionKind::MAP_SVG, map.svg);
+		writer.WriteSection(SectionKind::MAP_JSON, map.json_escaped_svg);
+	}
+
+	WriteRouter(writer, catalogue, router_settings);
+
+	writer.Finish();
+}
+
+bool serialization::IsFlatBase(std::string_view data)
+{
+	return data.size() >= sizeof(MAGIC) && data.substr(0, sizeof(MAGIC)) == string_view(MAGIC, sizeof(MAGIC));
+}
+
+Transport::Routing::LightTransportRouter serialization::DeserializeFlatBase(std::shared_ptr<const Transport::MappedFile> file,
+	Transport::TransportCatalogue& catalogue, Transport::Rendering::RenderSettings& render_settings,
+	Transport::Rendering::RenderedMapView& map)
+{
+	const FlatReader reader(file->GetData());
+
+	ReadStops(reader, catalogue);
+	ReadBuses(reader, catalogue);
+	ReadDistances(reader, catalogue);
+	ReadStopToBuses(reader, catalogue);
+	ReadIndexes(reader, catalogue);
+
+	DeserializeRenderSettings(reader.GetBytes(SectionKind::RENDER_SETTINGS), render_settings);
+	map.svg = reader.GetBytes(SectionKind::MAP_SVG);
+	map.json_escaped_svg = reader.GetBytes(SectionKind::MAP_JSON);
+
+	const auto settings = reader.Get<FlatRouterSettings>(SectionKind::ROUTER_SETTINGS);
+	Expect(settings.size() == 1, "router settings");
+	// the router takes the vertices of a stop from its id
+	const size_t vertex_count = settings[0].vertex_count;
+	Expect(vertex_count == catalogue.GetStopsCount() * 2, "vertex count");
+	Routing::RouterSettings router_settings;
+	router_settings.bus_wait_time = settings[0].bus_wait_time;
+	router_settings.bus_velocity = settings[0].bus_velocity;
+	router_settings.walking_velocity = settings[0].walking_velocity;
+	router_settings.walking_distance = settings[0].walking_distance;
+
+	// the edges and the routes stay in the file, which the router keeps mapped
+	auto edges = reader.Get<Routing::RouteEdge>(SectionKind::EDGES);
+	auto routes = reader.Get<Routing::RouteMatrix::Cell>(SectionKind::ROUTES);
+	// the router looks the names and the vertices of the edges up without checking them
+	const size_t stops_count = catalogue.GetStopsCount();
+	const size_t buses_count = catalogue.GetBuses().size();
+	Expect(all_of(edges.begin(), edges.end(), [vertex_count, stops_count, buses_count](const Routing::RouteEdge& edge) {
+		return edge.from < vertex_count && edge.to < vertex_count
+			&& edge.name_id < (edge.span_count == 0 ? stops_count : buses_count);
+		}), "edges");
+	// a route ends with an edge entering its vertex, the router walks the routes back along them
+	Expect(routes.size() == vertex_count * vertex_count, "routes size");
+	for (size_t i = 0; i < routes.size(); i++)
+	{
+		const uint32_t prev_edge = routes[i].prev_edge;
+		Expect(prev_edge == Routing::RouteMatrix::NO_ROUTE || prev_edge == Routing::RouteMatrix::NO_EDGE
+			|| (prev_edge < edges.size() && edges[prev_edge].to == i % vertex_count), "routes");
+	}
+	return Routing::LightTransportRouter(catalogue, router_settings, std::move(edges),
+		Routing::RouteMatrix(vertex_count, std::move(routes)), std::move(file));
+}
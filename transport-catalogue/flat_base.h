@@ -0,0 +1,35 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "mapped_file.h"
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace serialization {
+
+	// The flat base is an alternative to the protobuf one: a header with a table of sections,
+	// each a plain array aligned to 8 bytes in the layout and byte order of the writing host.
+	// The loader maps the file and the router uses the edges and the route matrix in place,
+	// so the load time doesn't grow with the V * V routes.
+
+	void SerializeFlatBase(const Transport::TransportCatalogue& catalogue, const std::string& filename,
+		const Transport::Rendering::RenderSettings& render_settings,
+		const Transport::Routing::RouterSettings& router_settings);
+
+	// IsFlatBase needs only this many first bytes of a file
+	constexpr size_t FLAT_BASE_MAGIC_SIZE = 8;
+
+	// true if data starts like a flat base
+	bool IsFlatBase(std::string_view data);
+
+	// the catalogue gets copies of the stops, buses and indexes, the router and the map refer
+	// to the file; throws std::invalid_argument if the file is malformed
+	Transport::Routing::LightTransportRouter DeserializeFlatBase(std::shared_ptr<const Transport::MappedFile> file,
+		Transport::TransportCatalogue& catalogue, Transport::Rendering::RenderSettings& render_settings,
+		Transport::Rendering::RenderedMapView& map);
+}
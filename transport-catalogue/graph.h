@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <memory_resource>
 #include <vector>
 
 namespace graph {
@@ -20,12 +21,13 @@ namespace graph {
     template <typename Weight>
     class DirectedWeightedGraph {
     private:
-        using IncidenceList = std::vector<EdgeId>;
+        using IncidenceList = std::pmr::vector<EdgeId>;
         using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
 
     public:
         DirectedWeightedGraph() = default;
-        explicit DirectedWeightedGraph(size_t vertex_count);
+        explicit DirectedWeightedGraph(size_t vertex_count,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
         EdgeId AddEdge(const Edge<Weight>& edge);
 
         size_t GetVertexCount() const;
@@ -33,17 +35,18 @@ namespace graph {
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
-        const std::vector<Edge<Weight>>& GetEdges() const;
-        const std::vector<IncidenceList>& GetIncidenceLists() const;
+        const std::pmr::vector<Edge<Weight>>& GetEdges() const;
+        const std::pmr::vector<IncidenceList>& GetIncidenceLists() const;
 
     private:
-        std::vector<Edge<Weight>> edges_;
-        std::vector<IncidenceList> incidence_lists_;
+        std::pmr::vector<Edge<Weight>> edges_;
+        std::pmr::vector<IncidenceList> incidence_lists_;
     };
 
     template <typename Weight>
-    DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count) {
+    DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, std::pmr::memory_resource* resource)
+        : edges_(resource)
+        , incidence_lists_(vertex_count, resource) {
     }
 
     template <typename Weight>
@@ -75,13 +78,13 @@ namespace graph {
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
     template<typename Weight>
-    inline const std::vector<Edge<Weight>>& DirectedWeightedGraph<Weight>::GetEdges() const
+    inline const std::pmr::vector<Edge<Weight>>& DirectedWeightedGraph<Weight>::GetEdges() const
     {
         return edges_;
     }
 
     template<typename Weight>
-    inline const std::vector<typename DirectedWeightedGraph<Weight>::IncidenceList>& DirectedWeightedGraph<Weight>::GetIncidenceLists() const
+    inline const std::pmr::vector<typename DirectedWeightedGraph<Weight>::IncidenceList>& DirectedWeightedGraph<Weight>::GetIncidenceLists() const
     {
         return incidence_lists_;
     }
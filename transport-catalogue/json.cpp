@@ -1,240 +1,389 @@
 #include "json.h"
 
-#include <iterator>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
+        // Gives the input as contiguous chunks: a stream is read into a buffer block by block,
+        // a string in memory is one chunk.
+        class Reader {
+        public:
+            static constexpr size_t CHUNK_SIZE = 64 * 1024;
 
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
+            explicit Reader(std::istream& input)
+                : input_(input.rdbuf())
+                , buffer_(CHUNK_SIZE) {
             }
-            return s;
-        }
 
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
+            explicit Reader(std::string_view input)
+                : pos_(input.data())
+                , end_(input.data() + input.size()) {
+            }
 
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
+            // the unread part of the current chunk, empty at the end of the input;
+            // valid until the next call which reads past it
+            std::string_view Available() {
+                if (pos_ == end_) {
+                    Refill();
                 }
-                result.push_back(LoadNode(input));
+                return { pos_, static_cast<size_t>(end_ - pos_) };
             }
-            if (!input) {
-                throw ParsingError("Array parsing error"s);
+
+            void Advance(size_t count) {
+                pos_ += count;
             }
-            return Node(std::move(result));
-        }
 
-        Node LoadDict(std::istream& input) {
-            Dict dict;
+            int Peek() {
+                if (pos_ == end_ && !Refill()) {
+                    return EOF;
+                }
+                return static_cast<unsigned char>(*pos_);
+            }
 
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        dict.emplace(std::move(key), LoadNode(input));
+            int Get() {
+                const int c = Peek();
+                if (c != EOF) {
+                    ++pos_;
+                }
+                return c;
+            }
+
+            // skips spaces and returns the next character without reading it, EOF at the end
+            int PeekNonSpace() {
+                while (pos_ != end_ || Refill()) {
+                    while (pos_ != end_ && IsSpace(*pos_)) {
+                        ++pos_;
                     }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                    if (pos_ != end_) {
+                        return static_cast<unsigned char>(*pos_);
                     }
                 }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                return EOF;
+            }
+
+            int GetNonSpace() {
+                const int c = PeekNonSpace();
+                if (c != EOF) {
+                    ++pos_;
+                }
+                return c;
+            }
+
+        private:
+            static bool IsSpace(char c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+            }
+
+            bool Refill() {
+                if (!input_) {
+                    return false;
                 }
+                const auto count = input_->sgetn(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+                pos_ = buffer_.data();
+                end_ = pos_ + std::max<std::streamsize>(count, 0);
+                return pos_ != end_;
             }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
+
+        private:
+            std::streambuf* input_ = nullptr;
+            std::vector<char> buffer_;
+            const char* pos_ = nullptr;
+            const char* end_ = nullptr;
+        };
+
+        // position of the first '"', '\\', '\n' or '\r' in s, s.size() if there is none;
+        // eight characters are tested at once
+        size_t FindStringSpecial(std::string_view s) {
+            constexpr uint64_t ONES = 0x0101010101010101ull;
+            constexpr uint64_t HIGHS = 0x8080808080808080ull;
+            // nonzero if some byte of word equals c, exact for the first such byte
+            const auto has_byte = [](uint64_t word, char c) {
+                const uint64_t x = word ^ (ONES * static_cast<unsigned char>(c));
+                return (x - ONES) & ~x & HIGHS;
+            };
+
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= s.size(); i += sizeof(uint64_t)) {
+                uint64_t word;
+                std::memcpy(&word, s.data() + i, sizeof(word));
+                if (has_byte(word, '"') | has_byte(word, '\\') | has_byte(word, '\n') | has_byte(word, '\r')) {
+                    break;
+                }
+            }
+            for (; i < s.size(); ++i) {
+                const char c = s[i];
+                if (c == '"' || c == '\\' || c == '\n' || c == '\r') {
+                    return i;
+                }
             }
-            return Node(std::move(dict));
+            return s.size();
         }
 
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true) {
-                if (it == end) {
-                    throw ParsingError("String parsing error");
-                }
-                const char ch = *it;
-                if (ch == '"') {
-                    ++it;
+        bool IsNumberChar(int c) {
+            return std::isdigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+        }
+
+        class Parser {
+        public:
+            Parser(Reader& reader, Handler& handler)
+                : reader_(reader)
+                , handler_(handler) {
+            }
+
+            void ParseNode() {
+                const int c = reader_.PeekNonSpace();
+                if (c == EOF) {
+                    throw ParsingError("Unexpected EOF"s);
+                }
+                switch (c) {
+                case '[':
+                    reader_.Advance(1);
+                    ParseArray();
+                    break;
+                case '{':
+                    reader_.Advance(1);
+                    ParseDict();
+                    break;
+                case '"':
+                    reader_.Advance(1);
+                    handler_.OnString(LoadString());
+                    break;
+                case 't':
+                    //  [[fallthrough]] ()   ,  
+                    //    ,     
+                    //       case,    
+                    //  break, return  throw.
+                    //   ,  t  f,    
+                    //  true  false
+                    [[fallthrough]];
+                case 'f':
+                    ParseBool();
+                    break;
+                case 'n':
+                    ParseNull();
+                    break;
+                default:
+                    ParseNumber();
                     break;
                 }
-                else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
+            }
+
+        private:
+            void ParseArray() {
+                handler_.OnStartArray();
+                for (int c; (c = reader_.PeekNonSpace()) != EOF && c != ']';) {
+                    if (c == ',') {
+                        reader_.Advance(1);
+                    }
+                    ParseNode();
+                }
+                if (reader_.Get() == EOF) {
+                    throw ParsingError("Array parsing error"s);
+                }
+                handler_.OnEndArray();
+            }
+
+            void ParseDict() {
+                handler_.OnStartDict();
+                int c;
+                while ((c = reader_.GetNonSpace()) != EOF && c != '}') {
+                    if (c == '"') {
+                        // the key is passed before ':' is read, as reading may replace the chunk it points to
+                        handler_.OnKey(LoadString());
+                        if (c = reader_.GetNonSpace(); c != ':') {
+                            throw ParsingError(": is expected but '"s + static_cast<char>(c) + "' has been found"s);
+                        }
+                        ParseNode();
+                    }
+                    else if (c != ',') {
+                        throw ParsingError(R"(',' is expected but ')"s + static_cast<char>(c) + "' has been found"s);
+                    }
+                }
+                if (c == EOF) {
+                    throw ParsingError("Dictionary parsing error"s);
+                }
+                handler_.OnEndDict();
+            }
+
+            // reads the rest of a string after the opening quote; the result points either
+            // into the input or into scratch_, and is valid until the next read
+            std::string_view LoadString() {
+                scratch_.clear();
+                bool copied = false;
+                while (true) {
+                    const auto chunk = reader_.Available();
+                    if (chunk.empty()) {
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
-                    switch (escaped_char) {
+                    const size_t special = FindStringSpecial(chunk);
+                    if (special == chunk.size()) {
+                        // the string goes on in the next chunk
+                        scratch_.append(chunk);
+                        copied = true;
+                        reader_.Advance(chunk.size());
+                        continue;
+                    }
+                    const char ch = chunk[special];
+                    if (ch == '"') {
+                        reader_.Advance(special + 1);
+                        if (!copied) {
+                            return chunk.substr(0, special);
+                        }
+                        scratch_.append(chunk.data(), special);
+                        return scratch_;
+                    }
+                    if (ch != '\\') {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    scratch_.append(chunk.data(), special);
+                    copied = true;
+                    reader_.Advance(special + 1);
+                    switch (const int escaped_char = reader_.Get()) {
                     case 'n':
-                        s.push_back('\n');
+                        scratch_.push_back('\n');
                         break;
                     case 't':
-                        s.push_back('\t');
+                        scratch_.push_back('\t');
                         break;
                     case 'r':
-                        s.push_back('\r');
+                        scratch_.push_back('\r');
                         break;
                     case '"':
-                        s.push_back('"');
+                        scratch_.push_back('"');
                         break;
                     case '\\':
-                        s.push_back('\\');
+                        scratch_.push_back('\\');
                         break;
+                    case EOF:
+                        throw ParsingError("String parsing error");
                     default:
-                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                        throw ParsingError("Unrecognized escape sequence \\"s + static_cast<char>(escaped_char));
                     }
                 }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
+            }
+
+            std::string_view LoadLiteral() {
+                scratch_.clear();
+                while (std::isalpha(reader_.Peek())) {
+                    scratch_.push_back(static_cast<char>(reader_.Get()));
+                }
+                return scratch_;
+            }
+
+            void ParseBool() {
+                const auto s = LoadLiteral();
+                if (s == "true"sv) {
+                    handler_.OnBool(true);
+                }
+                else if (s == "false"sv) {
+                    handler_.OnBool(false);
                 }
                 else {
-                    s.push_back(ch);
+                    throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
                 }
-                ++it;
             }
 
-            return Node(std::move(s));
-        }
-
-        Node LoadBool(std::istream& input) {
-            const auto s = LoadLiteral(input);
-            if (s == "true"sv) {
-                return Node{ true };
-            }
-            else if (s == "false"sv) {
-                return Node{ false };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+            void ParseNull() {
+                if (const auto literal = LoadLiteral(); literal == "null"sv) {
+                    handler_.OnNull();
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+                }
             }
-        }
 
-        Node LoadNull(std::istream& input) {
-            if (auto literal = LoadLiteral(input); literal == "null"sv) {
-                return Node{ nullptr };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+            // the characters of a number, in the input when it ends within the chunk
+            std::string_view LoadNumber() {
+                const auto chunk = reader_.Available();
+                const auto length = static_cast<size_t>(std::find_if_not(chunk.begin(), chunk.end(), IsNumberChar) - chunk.begin());
+                reader_.Advance(length);
+                if (length < chunk.size()) {
+                    return chunk.substr(0, length);
+                }
+                scratch_.assign(chunk);
+                while (IsNumberChar(reader_.Peek())) {
+                    scratch_.push_back(static_cast<char>(reader_.Get()));
+                }
+                return scratch_;
             }
-        }
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
+            void ParseNumber() {
+                const auto text = LoadNumber();
+                const char* const end = text.data() + text.size();
+                const char* p = text.data();
 
-            //   parsed_num    input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-            };
+                const auto read_digits = [&p, end] {
+                    if (p == end || !std::isdigit(*p)) {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (p != end && std::isdigit(*p)) {
+                        ++p;
+                    }
+                };
 
-            //       parsed_num  input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
-                    throw ParsingError("A digit is expected"s);
+                if (p != end && *p == '-') {
+                    ++p;
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                // 0 has no more digits in the integer part
+                if (p != end && *p == '0') {
+                    ++p;
+                }
+                else {
+                    read_digits();
                 }
-            };
-
-            if (input.peek() == '-') {
-                read_char();
-            }
-            //    
-            if (input.peek() == '0') {
-                read_char();
-                //  0  JSON     
-            }
-            else {
-                read_digits();
-            }
-
-            bool is_int = true;
-            //    
-            if (input.peek() == '.') {
-                read_char();
-                read_digits();
-                is_int = false;
-            }
 
-            //    
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+                bool is_int = true;
+                if (p != end && *p == '.') {
+                    ++p;
+                    read_digits();
+                    is_int = false;
+                }
+                if (p != end && (*p == 'e' || *p == 'E')) {
+                    ++p;
+                    if (p != end && (*p == '+' || *p == '-')) {
+                        ++p;
+                    }
+                    read_digits();
+                    is_int = false;
+                }
+                if (p != end) {
+                    throw ParsingError("Failed to parse '"s + std::string(text) + "' as number"s);
                 }
-                read_digits();
-                is_int = false;
-            }
 
-            try {
+                // the handler is called outside of the checks, so its own exceptions pass through
                 if (is_int) {
-                    //      int
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                        //   , ,  
-                        //       double
+                    int value = 0;
+                    // an int out of range is read as double
+                    if (std::from_chars(text.data(), end, value).ec == std::errc{}) {
+                        handler_.OnInt(value);
+                        return;
                     }
                 }
-                return std::stod(parsed_num);
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+                double value = 0.;
+                if (std::from_chars(text.data(), end, value).ec != std::errc{}) {
+                    throw ParsingError("Failed to convert "s + std::string(text) + " to number"s);
+                }
+                handler_.OnDouble(value);
             }
-        }
 
-        Node LoadNode(std::istream& input) {
-            char c;
-            if (!(input >> c)) {
-                throw ParsingError("Unexpected EOF"s);
-            }
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                //  [[fallthrough]] ()   ,  
-                //    ,     
-                //       case,    
-                //  break, return  throw.
-                //   ,  t  f,    
-                //  true  false
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
-            }
-        }
+        private:
+            Reader& reader_;
+            Handler& handler_;
+            // the text of a string, literal or number which is not in the input as is
+            std::string scratch_;
+        };
 
         struct PrintContext {
             std::ostream& out;
+            PrintFormat format;
             int indent_step = 4;
             int indent = 0;
 
@@ -244,8 +393,16 @@ namespace json {
                 }
             }
 
+            // a line break and the indent before an item of a container, nothing in the compact format
+            void PrintItemBreak() const {
+                if (!format.compact) {
+                    out.put('\n');
+                    PrintIndent();
+                }
+            }
+
             PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
+                return { out, format, indent_step, indent_step + indent };
             }
         };
 
@@ -256,7 +413,7 @@ namespace json {
             ctx.out << value;
         }
 
-        void PrintString(const std::string& value, std::ostream& out) {
+        void PrintString(std::string_view value, std::ostream& out) {
             out.put('"');
             for (const char c : value) {
                 switch (c) {
@@ -281,7 +438,17 @@ namespace json {
         }
 
         template <>
-        void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
+        void PrintValue<double>(const double& value, const PrintContext& ctx) {
+            if (!ctx.format.round_trip_doubles) {
+                ctx.out << value;
+                return;
+            }
+            char buffer[MAX_DOUBLE_CHARS];
+            ctx.out.write(buffer, FormatDouble(value, true, buffer) - buffer);
+        }
+
+        template <>
+        void PrintValue<String>(const String& value, const PrintContext& ctx) {
             PrintString(value, ctx.out);
         }
 
@@ -302,7 +469,7 @@ namespace json {
         template <>
         void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
-            out << "[\n"sv;
+            out.put('[');
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const Node& node : nodes) {
@@ -310,20 +477,22 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.put(',');
                 }
-                inner_ctx.PrintIndent();
+                inner_ctx.PrintItemBreak();
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
-            ctx.PrintIndent();
+            if (nodes.empty() && !ctx.format.compact) {
+                out.put('\n');
+            }
+            ctx.PrintItemBreak();
             out.put(']');
         }
 
         template <>
         void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
-            out << "{\n"sv;
+            out.put('{');
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const auto& [key, node] : nodes) {
@@ -331,15 +500,17 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.put(',');
                 }
-                inner_ctx.PrintIndent();
+                inner_ctx.PrintItemBreak();
                 PrintString(key, ctx.out);
-                out << ": "sv;
+                out << (ctx.format.compact ? ":"sv : ": "sv);
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
-            ctx.PrintIndent();
+            if (nodes.empty() && !ctx.format.compact) {
+                out.put('\n');
+            }
+            ctx.PrintItemBreak();
             out.put('}');
         }
 
@@ -353,12 +524,264 @@ namespace json {
 
     }  // namespace
 
+    Node& Dict::operator[](std::string_view key) {
+        const auto it = LowerBound(key);
+        if (it != members_.end() && it->first == key) {
+            return members_[it - members_.begin()].second;
+        }
+        return members_.emplace(it, key, Node{})->second;
+    }
+
+    std::pair<Dict::iterator, bool> Dict::emplace(std::string_view key, Node value) {
+        const auto it = LowerBound(key);
+        const auto pos = members_.begin() + (it - members_.cbegin());
+        if (it != members_.end() && it->first == key) {
+            return { pos, false };
+        }
+        return { members_.emplace(pos, key, std::move(value)), true };
+    }
+
+    Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+        return std::lower_bound(members_.begin(), members_.end(), key,
+            [](const value_type& member, std::string_view key) {
+                return std::string_view(member.first) < key;
+            });
+    }
+
     Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+        NodeHandler handler;
+        Parse(input, handler);
+        return Document{ handler.Extract() };
+    }
+
+    void Parse(std::istream& input, Handler& handler) {
+        Reader reader(input);
+        Parser(reader, handler).ParseNode();
+    }
+
+    void Parse(std::string_view input, Handler& handler) {
+        Reader reader(input);
+        Parser(reader, handler).ParseNode();
+    }
+
+    void ParseWhole(std::string_view input, Handler& handler) {
+        Reader reader(input);
+        Parser(reader, handler).ParseNode();
+        if (reader.PeekNonSpace() != EOF) {
+            throw ParsingError("Unexpected characters after the value"s);
+        }
+    }
+
+    NodeHandler::NodeHandler(std::pmr::memory_resource* resource)
+        : resource_(resource) {
+    }
+
+    void NodeHandler::OnNull() {
+        AddValue(Node{ nullptr });
+    }
+
+    void NodeHandler::OnBool(bool value) {
+        AddValue(Node{ value });
+    }
+
+    void NodeHandler::OnInt(int value) {
+        AddValue(Node{ value });
+    }
+
+    void NodeHandler::OnDouble(double value) {
+        AddValue(Node{ value });
+    }
+
+    void NodeHandler::OnString(std::string_view value) {
+        AddValue(Node{ String(value, resource_) });
+    }
+
+    void NodeHandler::OnKey(std::string_view key) {
+        if (stack_.empty() || !stack_.back().is_dict) {
+            throw ParsingError("Key outside of a dict"s);
+        }
+        if (stack_.back().dict.count(key) != 0) {
+            throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+        }
+        stack_.back().key = key;
+    }
+
+    void NodeHandler::OnStartArray() {
+        stack_.push_back(Container{ false, Array(resource_), Dict(resource_), String(resource_) });
+    }
+
+    void NodeHandler::OnEndArray() {
+        if (stack_.empty() || stack_.back().is_dict) {
+            throw ParsingError("Unexpected end of array"s);
+        }
+        Node value{ std::move(stack_.back().array) };
+        stack_.pop_back();
+        AddValue(std::move(value));
+    }
+
+    void NodeHandler::OnStartDict() {
+        stack_.push_back(Container{ true, Array(resource_), Dict(resource_), String(resource_) });
+    }
+
+    void NodeHandler::OnEndDict() {
+        if (stack_.empty() || !stack_.back().is_dict) {
+            throw ParsingError("Unexpected end of dict"s);
+        }
+        Node value{ std::move(stack_.back().dict) };
+        stack_.pop_back();
+        AddValue(std::move(value));
+    }
+
+    bool NodeHandler::InProgress() const {
+        return !stack_.empty();
+    }
+
+    bool NodeHandler::HasValue() const {
+        return value_.has_value();
+    }
+
+    Node NodeHandler::Extract() {
+        if (!value_) {
+            throw ParsingError("Incomplete value"s);
+        }
+        Node value = std::move(*value_);
+        value_.reset();
+        return value;
+    }
+
+    void NodeHandler::AddValue(Node value) {
+        if (stack_.empty()) {
+            value_ = std::move(value);
+            return;
+        }
+        auto& container = stack_.back();
+        if (container.is_dict) {
+            container.dict.emplace(container.key, std::move(value));
+        }
+        else {
+            container.array.push_back(std::move(value));
+        }
+    }
+
+    StreamingDictHandler::StreamingDictHandler(std::vector<std::string> streamed_keys, ItemCallback on_item,
+        MemberCallback on_member)
+        : streamed_keys_(std::move(streamed_keys))
+        , on_item_(std::move(on_item))
+        , on_member_(std::move(on_member))
+        , item_arena_(item_buffer_.data(), item_buffer_.size())
+        , item_(&item_arena_) {
+    }
+
+    void StreamingDictHandler::OnNull() {
+        GetCurrent().OnNull();
+        AddCompleteValue();
     }
 
-    void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), PrintContext{ output });
+    void StreamingDictHandler::OnBool(bool value) {
+        GetCurrent().OnBool(value);
+        AddCompleteValue();
+    }
+
+    void StreamingDictHandler::OnInt(int value) {
+        GetCurrent().OnInt(value);
+        AddCompleteValue();
+    }
+
+    void StreamingDictHandler::OnDouble(double value) {
+        GetCurrent().OnDouble(value);
+        AddCompleteValue();
+    }
+
+    void StreamingDictHandler::OnString(std::string_view value) {
+        GetCurrent().OnString(value);
+        AddCompleteValue();
+    }
+
+    void StreamingDictHandler::OnKey(std::string_view key) {
+        if (!streaming_ && !member_.InProgress()) {
+            if (root_.count(key) != 0) {
+                throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+            }
+            key_ = key;
+            return;
+        }
+        GetCurrent().OnKey(key);
+    }
+
+    void StreamingDictHandler::OnStartArray() {
+        if (root_started_ && !streaming_ && !member_.InProgress()
+            && std::find(streamed_keys_.begin(), streamed_keys_.end(), key_) != streamed_keys_.end()) {
+            streaming_ = true;
+            return;
+        }
+        GetCurrent().OnStartArray();
+    }
+
+    void StreamingDictHandler::OnEndArray() {
+        if (streaming_ && !item_.InProgress()) {
+            streaming_ = false;
+            return;
+        }
+        GetCurrent().OnEndArray();
+        AddCompleteValue();
+    }
+
+    void StreamingDictHandler::OnStartDict() {
+        if (!root_started_) {
+            root_started_ = true;
+            return;
+        }
+        GetCurrent().OnStartDict();
+    }
+
+    void StreamingDictHandler::OnEndDict() {
+        if (!streaming_ && !member_.InProgress()) {
+            // end of the root dict
+            return;
+        }
+        GetCurrent().OnEndDict();
+        AddCompleteValue();
+    }
+
+    Dict StreamingDictHandler::ExtractRoot() {
+        return std::move(root_);
+    }
+
+    NodeHandler& StreamingDictHandler::GetCurrent() {
+        if (!root_started_) {
+            throw ParsingError("The root is not a dict"s);
+        }
+        return streaming_ ? item_ : member_;
+    }
+
+    void StreamingDictHandler::AddCompleteValue() {
+        if (streaming_ && item_.HasValue()) {
+            {
+                const Node item = item_.Extract();
+                on_item_(key_, item);
+            }
+            item_arena_.release();
+        }
+        else if (!streaming_ && member_.HasValue()) {
+            const auto& value = root_.emplace(key_, member_.Extract()).first->second;
+            if (on_member_) {
+                on_member_(key_, value);
+            }
+        }
+    }
+
+    void Print(const Document& doc, std::ostream& output, PrintFormat format) {
+        PrintNode(doc.GetRoot(), PrintContext{ output, format });
+    }
+
+    char* FormatDouble(double value, bool round_trip, char* buffer) {
+        if (round_trip) {
+            // without a format and precision to_chars gives the shortest text which reads back exactly
+            return std::to_chars(buffer, buffer + MAX_DOUBLE_CHARS, value).ptr;
+        }
+        // the same conversion as std::ostream << double with the default flags and precision
+        const int size = std::snprintf(buffer, MAX_DOUBLE_CHARS, "%g", value);
+        return buffer + size;
     }
 
 }  // namespace json
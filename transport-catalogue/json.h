@@ -1,16 +1,63 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <functional>
 #include <iostream>
-#include <map>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+
+    // Containers and strings of a node take memory from the resource they were created with,
+    // so a whole parsed value may live in one arena. Copies use the default resource.
+    using String = std::pmr::string;
+    using Array = std::pmr::vector<Node>;
+
+    // Members of an object in a flat array sorted by key. Iteration goes in key order, like std::map;
+    // small objects are searched linearly, larger ones by binary search.
+    class Dict {
+    public:
+        using value_type = std::pair<String, Node>;
+        using Members = std::pmr::vector<value_type>;
+        using iterator = Members::iterator;
+        using const_iterator = Members::const_iterator;
+
+        // objects up to this size are searched linearly
+        static constexpr size_t LINEAR_SEARCH_SIZE = 8;
+
+        Dict() = default;
+        explicit Dict(std::pmr::memory_resource* resource);
+
+        const Node& at(std::string_view key) const;
+        Node& operator[](std::string_view key);
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+
+        // does nothing and returns false if the key is already there
+        std::pair<iterator, bool> emplace(std::string_view key, Node value);
+
+        const_iterator begin() const;
+        const_iterator end() const;
+        size_t size() const;
+        bool empty() const;
+
+        bool operator==(const Dict& rhs) const;
+
+    private:
+        // the first member with a key not less than key
+        const_iterator LowerBound(std::string_view key) const;
+
+    private:
+        Members members_;
+    };
 
     class ParsingError : public std::runtime_error {
     public:
@@ -18,11 +65,18 @@ namespace json {
     };
 
     class Node final
-        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, String> {
     public:
         using variant::variant;
         using Value = variant;
 
+        Node(std::string_view value)
+            : variant(String(value)) {
+        }
+        Node(const std::string& value)
+            : variant(String(value)) {
+        }
+
         bool IsInt() const {
             return std::holds_alternative<int>(*this);
         }
@@ -77,15 +131,15 @@ namespace json {
         }
 
         bool IsString() const {
-            return std::holds_alternative<std::string>(*this);
+            return std::holds_alternative<String>(*this);
         }
-        const std::string& AsString() const {
+        const String& AsString() const {
             using namespace std::literals;
             if (!IsString()) {
                 throw std::logic_error("Not a string"s);
             }
 
-            return std::get<std::string>(*this);
+            return std::get<String>(*this);
         }
 
         bool IsDict() const {
@@ -113,6 +167,56 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    inline Dict::Dict(std::pmr::memory_resource* resource)
+        : members_(resource) {
+    }
+
+    inline const Node& Dict::at(std::string_view key) const {
+        using namespace std::literals;
+        const auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
+        }
+        return it->second;
+    }
+
+    inline Dict::const_iterator Dict::find(std::string_view key) const {
+        if (members_.size() <= LINEAR_SEARCH_SIZE) {
+            for (auto it = members_.begin(); it != members_.end(); ++it) {
+                if (it->first == key) {
+                    return it;
+                }
+            }
+            return members_.end();
+        }
+        const auto it = LowerBound(key);
+        return it != members_.end() && it->first == key ? it : members_.end();
+    }
+
+    inline size_t Dict::count(std::string_view key) const {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    inline Dict::const_iterator Dict::begin() const {
+        return members_.begin();
+    }
+
+    inline Dict::const_iterator Dict::end() const {
+        return members_.end();
+    }
+
+    inline size_t Dict::size() const {
+        return members_.size();
+    }
+
+    inline bool Dict::empty() const {
+        return members_.empty();
+    }
+
+    inline bool Dict::operator==(const Dict& rhs) const {
+        return members_ == rhs.members_;
+    }
+
     class Document {
     public:
         explicit Document(Node root)
@@ -137,6 +241,140 @@ namespace json {
 
     Document Load(std::istream& input);
 
-    void Print(const Document& doc, std::ostream& output);
+    // Receives the values of a document parsed by Parse() as a sequence of events in document order.
+    // A dict member is reported as OnKey() followed by the events of its value.
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void OnNull() = 0;
+        virtual void OnBool(bool value) = 0;
+        virtual void OnInt(int value) = 0;
+        virtual void OnDouble(double value) = 0;
+        // the views are valid only during the call
+        virtual void OnString(std::string_view value) = 0;
+        virtual void OnKey(std::string_view key) = 0;
+        virtual void OnStartArray() = 0;
+        virtual void OnEndArray() = 0;
+        virtual void OnStartDict() = 0;
+        virtual void OnEndDict() = 0;
+    };
+
+    // parses a document from input without building it, passing the events to handler;
+    // the stream is read in blocks, so the characters after the document may be consumed
+    void Parse(std::istream& input, Handler& handler);
+    void Parse(std::string_view input, Handler& handler);
+    // parses input that holds a single value and nothing but spaces after it
+    void ParseWhole(std::string_view input, Handler& handler);
+
+    // Builds a node from the events of a single value.
+    class NodeHandler final : public Handler {
+    public:
+        // the node is allocated from resource, which must outlive it
+        explicit NodeHandler(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        void OnNull() override;
+        void OnBool(bool value) override;
+        void OnInt(int value) override;
+        void OnDouble(double value) override;
+        void OnString(std::string_view value) override;
+        void OnKey(std::string_view key) override;
+        void OnStartArray() override;
+        void OnEndArray() override;
+        void OnStartDict() override;
+        void OnEndDict() override;
+
+        // an array or a dict is started but not finished yet
+        bool InProgress() const;
+
+        // the value is complete
+        bool HasValue() const;
+
+        // takes the complete value, the handler is ready for the next one
+        Node Extract();
+
+    private:
+        struct Container {
+            bool is_dict = false;
+            Array array;
+            Dict dict;
+            // key of the dict member being read
+            String key;
+        };
+
+        void AddValue(Node value);
+
+    private:
+        std::pmr::memory_resource* resource_;
+        std::vector<Container> stack_;
+        std::optional<Node> value_;
+    };
+
+    // Builds the members of the root dict, except the arrays named in streamed_keys:
+    // their items are passed to on_item one by one as soon as each of them is parsed,
+    // and are not kept. on_member, if given, sees every other member once it is complete.
+    // An item lives in an arena which is reset after on_item returns, so on_item must copy
+    // what it keeps.
+    class StreamingDictHandler final : public Handler {
+    public:
+        using ItemCallback = std::function<void(std::string_view key, const Node& item)>;
+        using MemberCallback = std::function<void(std::string_view key, const Node& value)>;
+
+        StreamingDictHandler(std::vector<std::string> streamed_keys, ItemCallback on_item,
+            MemberCallback on_member = {});
+
+        void OnNull() override;
+        void OnBool(bool value) override;
+        void OnInt(int value) override;
+        void OnDouble(double value) override;
+        void OnString(std::string_view value) override;
+        void OnKey(std::string_view key) override;
+        void OnStartArray() override;
+        void OnEndArray() override;
+        void OnStartDict() override;
+        void OnEndDict() override;
+
+        // members of the root dict read so far, without the streamed arrays
+        Dict ExtractRoot();
+
+    private:
+        NodeHandler& GetCurrent();
+        void AddCompleteValue();
+
+    private:
+        std::vector<std::string> streamed_keys_;
+        ItemCallback on_item_;
+        MemberCallback on_member_;
+
+        bool root_started_ = false;
+        // inside one of the streamed arrays
+        bool streaming_ = false;
+        std::string key_;
+        NodeHandler member_;
+
+        // a typical item fits into the initial buffer, so resetting the arena frees nothing
+        std::array<std::byte, 4096> item_buffer_;
+        std::pmr::monotonic_buffer_resource item_arena_;
+        NodeHandler item_;
+
+        Dict root_;
+    };
+
+    // Layout of the text written by Print and Writer.
+    struct PrintFormat {
+        // no line breaks, indents and spaces
+        bool compact = false;
+        // doubles in the shortest form which reads back to the same value, instead of 6 significant digits
+        bool round_trip_doubles = false;
+    };
+
+    void Print(const Document& doc, std::ostream& output, PrintFormat format = {});
+
+    // enough for any double in either format
+    constexpr size_t MAX_DOUBLE_CHARS = 32;
+
+    // writes value to buffer of MAX_DOUBLE_CHARS, as std::ostream << value with the default flags
+    // or in the shortest round-trip form, and returns the end of the text
+    char* FormatDouble(double value, bool round_trip, char* buffer);
 
 }  // namespace json
@@ -0,0 +1,196 @@
+#include "json.h"
+#include "json_builder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Measures the throughput of json::Parse on generated make_base and process_requests inputs,
+// from a stream and from a string_view, with and without building the document.
+// Usage: json_benchmark [STOPS] [RUNS]
+
+using namespace std;
+
+namespace {
+	// counts the values, so the events are not optimized away
+	class CountingHandler final : public json::Handler {
+	public:
+		void OnNull() override { ++count_; }
+		void OnBool(bool) override { ++count_; }
+		void OnInt(int) override { ++count_; }
+		void OnDouble(double) override { ++count_; }
+		void OnString(std::string_view value) override { count_ += value.size(); }
+		void OnKey(std::string_view key) override { count_ += key.size(); }
+		void OnStartArray() override { ++count_; }
+		void OnEndArray() override {}
+		void OnStartDict() override { ++count_; }
+		void OnEndDict() override {}
+
+		size_t GetCount() const { return count_; }
+
+	private:
+		size_t count_ = 0;
+	};
+
+	string MakeStopName(size_t id)
+	{
+		static const char* const kinds[] = { "Ulitsa", "Prospekt", "Ploshchad", "Pereulok", "Shkola", "Rynok" };
+		return string(kinds[id % size(kinds)]) + " " + to_string(id);
+	}
+
+	// stops on a city-sized square with distances to the next stops, and routes over them
+	string MakeBaseInput(size_t stop_count, mt19937& generator)
+	{
+		uniform_real_distribution<double> lat(55.5, 55.9);
+		uniform_real_distribution<double> lng(37.3, 37.9);
+		uniform_int_distribution<int> distance(300, 3000);
+		uniform_int_distribution<size_t> stop(0, stop_count - 1);
+
+		json::Builder builder;
+		builder.StartDict();
+		builder.Key("serialization_settings"s).StartDict().Key("file"s).Value("base.db"s).EndDict();
+		builder.Key("routing_settings"s).StartDict().Key("bus_wait_time"s).Value(6).Key("bus_velocity"s).Value(40).EndDict();
+		builder.Key("render_settings"s).StartDict()
+			.Key("width"s).Value(1200.).Key("height"s).Value(1200.).Key("padding"s).Value(50.)
+			.Key("stop_radius"s).Value(5.).Key("line_width"s).Value(14.)
+			.Key("underlayer_color"s).StartArray().Value(255).Value(255).Value(255).Value(0.85).EndArray()
+			.Key("color_palette"s).StartArray().Value("green"s).Value("red"s).Value("blue"s).EndArray()
+			.EndDict();
+
+		builder.Key("base_requests"s).StartArray();
+		for (size_t id = 0; id < stop_count; id++)
+		{
+			builder.StartDict()
+				.Key("type"s).Value("Stop"s)
+				.Key("name"s).Value(MakeStopName(id))
+				.Key("latitude"s).Value(lat(generator))
+				.Key("longitude"s).Value(lng(generator))
+				.Key("road_distances"s).StartDict();
+			for (size_t next = id + 1; next < min(id + 4, stop_count); next++)
+			{
+				builder.Key(MakeStopName(next)).Value(distance(generator));
+			}
+			builder.EndDict().EndDict();
+		}
+		for (size_t id = 0; id < stop_count / 4; id++)
+		{
+			builder.StartDict()
+				.Key("type"s).Value("Bus"s)
+				.Key("name"s).Value(to_string(id) + "k"s)
+				.Key("is_roundtrip"s).Value(id % 2 == 0)
+				.Key("stops"s).StartArray();
+			for (int i = 0; i < 12; i++)
+			{
+				builder.Value(MakeStopName(stop(generator)));
+			}
+			builder.EndArray().EndDict();
+		}
+		builder.EndArray().EndDict();
+
+		ostringstream out;
+		json::Print(json::Document{ builder.Build() }, out);
+		return out.str();
+	}
+
+	// a mix of the stat requests to the base above
+	string MakeStatInput(size_t stop_count, size_t request_count, mt19937& generator)
+	{
+		uniform_int_distribution<size_t> stop(0, stop_count - 1);
+
+		json::Builder builder;
+		builder.StartDict();
+		builder.Key("serialization_settings"s).StartDict().Key("file"s).Value("base.db"s).EndDict();
+		builder.Key("stat_requests"s).StartArray();
+		for (size_t id = 0; id < request_count; id++)
+		{
+			builder.StartDict().Key("id"s).Value(static_cast<int>(id));
+			switch (id % 3)
+			{
+			case 0:
+				builder.Key("type"s).Value("Bus"s).Key("name"s).Value(to_string(stop(generator) / 4) + "k"s);
+				break;
+			case 1:
+				builder.Key("type"s).Value("Stop"s).Key("name"s).Value(MakeStopName(stop(generator)));
+				break;
+			default:
+				builder.Key("type"s).Value("Route"s)
+					.Key("from"s).Value(MakeStopName(stop(generator)))
+					.Key("to"s).Value(MakeStopName(stop(generator)));
+			}
+			builder.EndDict();
+		}
+		builder.EndArray().EndDict();
+
+		ostringstream out;
+		json::Print(json::Document{ builder.Build() }, out);
+		return out.str();
+	}
+
+	// the best of runs, in MB/s
+	template <typename Parse>
+	double Measure(const string& input, size_t runs, Parse parse)
+	{
+		double best_seconds = numeric_limits<double>::infinity();
+		for (size_t run = 0; run < runs; run++)
+		{
+			const auto start = chrono::steady_clock::now();
+			parse();
+			best_seconds = min(best_seconds, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+		}
+		return input.size() / best_seconds / 1e6;
+	}
+
+	void Report(std::string_view name, const string& input, size_t runs)
+	{
+		size_t checksum = 0;
+		const double stream_events = Measure(input, runs, [&input, &checksum]() {
+			istringstream in(input);
+			CountingHandler handler;
+			json::Parse(in, handler);
+			checksum += handler.GetCount();
+			});
+		const double view_events = Measure(input, runs, [&input, &checksum]() {
+			CountingHandler handler;
+			json::Parse(std::string_view(input), handler);
+			checksum += handler.GetCount();
+			});
+		const double stream_nodes = Measure(input, runs, [&input, &checksum]() {
+			istringstream in(input);
+			json::NodeHandler handler;
+			json::Parse(in, handler);
+			checksum += handler.Extract().IsDict();
+			});
+		const double view_nodes = Measure(input, runs, [&input, &checksum]() {
+			json::NodeHandler handler;
+			json::Parse(std::string_view(input), handler);
+			checksum += handler.Extract().IsDict();
+			});
+
+		cout << name << " input, "sv << input.size() / 1024 << " KiB, MB/s:\n"sv
+			<< "  events from istream      "sv << stream_events << '\n'
+			<< "  events from string_view  "sv << view_events << '\n'
+			<< "  nodes from istream       "sv << stream_nodes << '\n'
+			<< "  nodes from string_view   "sv << view_nodes << '\n';
+		// keeps the results in use
+		if (checksum == 0)
+		{
+			cout << "  no values parsed\n"sv;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t stop_count = max<size_t>(argc > 1 ? stoul(argv[1]) : 5000, 4);
+	const size_t runs = max<size_t>(argc > 2 ? stoul(argv[2]) : 20, 1);
+
+	mt19937 generator(1);
+	Report("make_base"sv, MakeBaseInput(stop_count, generator), runs);
+	Report("process_requests"sv, MakeStatInput(stop_count, stop_count * 2, generator), runs);
+	return 0;
+}
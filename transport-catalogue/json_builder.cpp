@@ -47,10 +47,10 @@ Builder& json::Builder::Value(Node value)
 	}
 	if (nodes_stack_.back()->IsString())
 	{
-		const string key = nodes_stack_.back()->AsString();
+		const string key(nodes_stack_.back()->AsString());
 		nodes_stack_.pop_back();
 		key_buffer_.pop_back();
-		const_cast<Dict&>(nodes_stack_.back()->AsDict()).insert({ key, value });
+		const_cast<Dict&>(nodes_stack_.back()->AsDict()).emplace(key, value);
 	};
 
 	return *this;
@@ -83,11 +83,11 @@ DictItemContext json::Builder::StartDict()
 	}
 	if (nodes_stack_.back()->IsString())
 	{
-		const string key = nodes_stack_.back()->AsString();
+		const string key(nodes_stack_.back()->AsString());
 		nodes_stack_.pop_back();
 		key_buffer_.pop_back();
 		//      
-		const_cast<Dict&>(nodes_stack_.back()->AsDict()).insert({ key, Dict() });
+		const_cast<Dict&>(nodes_stack_.back()->AsDict()).emplace(key, Dict());
 		//   nodes_stack_    Node(Dict);
 		nodes_stack_.push_back(&(const_cast<Dict&>(nodes_stack_.back()->AsDict())[key]));
 	};
@@ -122,11 +122,11 @@ ArrayItemContext json::Builder::StartArray()
 	}
 	if (nodes_stack_.back()->IsString())
 	{
-		const string key = nodes_stack_.back()->AsString();
+		const string key(nodes_stack_.back()->AsString());
 		nodes_stack_.pop_back();
 		key_buffer_.pop_back();
 		//      
-		const_cast<Dict&>(nodes_stack_.back()->AsDict()).insert({ key, Array() });
+		const_cast<Dict&>(nodes_stack_.back()->AsDict()).emplace(key, Array());
 		//   nodes_stack_    Node(Array);
 		nodes_stack_.push_back(&(const_cast<Dict&>(nodes_stack_.back()->AsDict())[key]));
 	};
@@ -1,18 +1,48 @@
 #include "json_reader.h"
 #include "request_handler.h"
-#include "json_builder.h"
-
+#include "json_writer.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <memory_resource>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 using namespace Transport;
 
+// the base file is complete here only
+Transport::JsonReader::~JsonReader() = default;
+
+void Transport::JsonReader::SetInput(std::string_view text)
+{
+    input_text_ = text;
+}
+
+void Transport::JsonReader::ParseInput(json::Handler& handler)
+{
+    if (input_text_)
+    {
+        json::Parse(*input_text_, handler);
+    }
+    else
+    {
+        json::Parse(in_, handler);
+    }
+}
+
 void Transport::JsonReader::ReadInput()
 {
     using namespace json;
 
     //   { base_requests:... , stat_requests:... }
-    Document document = Load(in_);
+    NodeHandler handler;
+    ParseInput(handler);
+    const Document document{ handler.Extract() };
 
     //   (/)
     const auto& base_requests = document.GetRoot().AsDict().at("base_requests").AsArray();
@@ -27,7 +57,7 @@ void Transport::JsonReader::ReadInput()
     const auto& serialization_settings = document.GetRoot().AsDict().at("serialization_settings").AsDict();
     ReadSerializationSettings(serialization_settings);
 
-    out_ << "[\n";
+    out_ << (output_format_.compact ? "["sv : "[\n"sv);
     const auto& stat_requests = document.GetRoot().AsDict().at("stat_requests").AsArray();
     ReadStatRequests(stat_requests);
     out_ << "]\n";
@@ -38,47 +68,314 @@ void Transport::JsonReader::ReadMakeBaseInput()
     using namespace json;
 
     //   { base_requests:... , stat_requests:... }
-    Document document = Load(in_);
+    // base requests are handled while the input is parsed, one at a time, instead of after the whole tree is built
+    StreamingDictHandler handler({ "base_requests"s }, [this](std::string_view, const Node& request) {
+        ReadBaseRequest(request.AsDict());
+        });
+    ParseInput(handler);
+    const Dict root = handler.ExtractRoot();
 
-    //   (/)
-    const auto& base_requests = document.GetRoot().AsDict().at("base_requests").AsArray();
-    ReadBaseRequests(base_requests);
+    AddPendingBaseRequests();
 
-    const auto& serialization_settings = document.GetRoot().AsDict().at("serialization_settings").AsDict();
+    const auto& serialization_settings = root.at("serialization_settings").AsDict();
     ReadSerializationSettings(serialization_settings);
 
-    const auto& render_settings = document.GetRoot().AsDict().at("render_settings").AsDict();
+    const auto& render_settings = root.at("render_settings").AsDict();
     ReadRenderSettings(render_settings);
 
-    const auto& router_settings = document.GetRoot().AsDict().at("routing_settings").AsDict();
+    const auto& router_settings = root.at("routing_settings").AsDict();
     ReadRouterSettings(router_settings);
 }
 
-void Transport::JsonReader::ReadProcessRequest()
+void Transport::JsonReader::ProcessRequests(const BaseLoader& load_base)
 {
     using namespace json;
 
     //   { base_requests:... , stat_requests:... }
-    Document document = Load(in_);
+    // the base is loaded in the background from the moment serialization_settings are read,
+    // and each stat request is answered as soon as it is parsed and the base is ready
+    StreamingDictHandler handler({ "stat_requests"s },
+        [this](std::string_view, const Node& request) {
+            if (base_file_)
+            {
+                // the earlier requests have been answered already
+                AnswerStatRequest(request.AsDict());
+                return;
+            }
+            // the request lives in the parser arena, so it is copied
+            pending_stat_requests_.push_back(request);
+            if (base_.valid())
+            {
+                AnswerPendingStatRequests();
+            }
+        },
+        [this, &load_base](std::string_view key, const Node& value) {
+            if (key == "serialization_settings"sv)
+            {
+                StartLoadingBase(value.AsDict(), load_base);
+            }
+        });
 
-    const auto& serialization_settings = document.GetRoot().AsDict().at("serialization_settings").AsDict();
+    if (thread_count_ > 1)
+    {
+        // the responses are written by this thread, in the order of the requests
+        pool_.emplace(thread_count_, [this](const std::string& response) {
+            WriteResponse(response);
+            });
+    }
+
+    out_ << (output_format_.compact ? "["sv : "[\n"sv);
+    ParseInput(handler);
+    if (!base_file_ && !base_.valid())
+    {
+        // the stat requests came first, or there are none
+        StartLoadingBase(handler.ExtractRoot().at("serialization_settings").AsDict(), load_base);
+    }
+    AnswerPendingStatRequests();
+    if (pool_)
+    {
+        pool_->Finish();
+        pool_.reset();
+    }
+    out_ << "]\n";
+}
+
+void Transport::JsonReader::ProcessRequestLines(const BaseLoader& load_base)
+{
+    using namespace json;
+
+    line_mode_ = true;
+    output_format_.compact = true;
+
+    // the first line holds the settings, without them there is nothing to answer
+    std::string_view line;
+    bool has_settings = false;
+    while ((has_settings = ReadLine(line)) && line.find_first_not_of(" \t\r"sv) == std::string_view::npos)
+    {
+    }
+    if (!has_settings)
+    {
+        return;
+    }
+    try
+    {
+        NodeHandler handler;
+        ParseWhole(line, handler);
+        StartLoadingBase(handler.Extract().AsDict().at("serialization_settings").AsDict(), load_base);
+    }
+    catch (const ParsingError& e)
+    {
+        AnswerError("Malformed settings line: "s + e.what());
+    }
+    catch (const std::logic_error& e)
+    {
+        // not a dict or no serialization settings in it
+        AnswerError("Malformed settings line: "s + e.what());
+    }
+    if (!base_.valid())
+    {
+        out_.flush();
+        return;
+    }
+    base_file_ = base_.get();
+
+    if (thread_count_ > 1)
+    {
+        pool_.emplace(thread_count_, [this](const std::string& response) {
+            WriteResponse(response);
+            });
+    }
+
+    // a typical request fits into the initial buffer, so the arena allocates nothing after the first lines
+    std::array<std::byte, 4096> request_buffer;
+    std::pmr::monotonic_buffer_resource request_arena(request_buffer.data(), request_buffer.size());
+    size_t unflushed_count = 0;
+    while (true)
+    {
+        // the client may wait for the responses before it sends more requests
+        if (unflushed_count == LINE_FLUSH_BATCH || (unflushed_count != 0 && !IsInputAvailable()))
+        {
+            if (pool_)
+            {
+                pool_->Finish();
+            }
+            out_.flush();
+            unflushed_count = 0;
+        }
+        if (!ReadLine(line))
+        {
+            break;
+        }
+        if (line.find_first_not_of(" \t\r"sv) == std::string_view::npos)
+        {
+            continue;
+        }
+
+        {
+            NodeHandler handler(&request_arena);
+            std::optional<Node> request;
+            try
+            {
+                ParseWhole(line, handler);
+                request = handler.Extract();
+            }
+            catch (const ParsingError& e)
+            {
+                AnswerError(e.what());
+            }
+            if (request && request->IsDict())
+            {
+                AnswerStatRequest(request->AsDict());
+            }
+            else if (request)
+            {
+                AnswerError("A request must be a dict"s);
+            }
+        }
+        request_arena.release();
+        ++unflushed_count;
+    }
+
+    if (pool_)
+    {
+        pool_->Finish();
+        pool_.reset();
+    }
+    out_.flush();
+}
+
+bool Transport::JsonReader::ReadLine(std::string_view& line)
+{
+    if (!input_text_)
+    {
+        if (!std::getline(in_, line_))
+        {
+            return false;
+        }
+        line = line_;
+        return true;
+    }
+    if (input_text_->empty())
+    {
+        return false;
+    }
+    const size_t end = std::min(input_text_->find('\n'), input_text_->size());
+    line = input_text_->substr(0, end);
+    input_text_->remove_prefix(std::min(end + 1, input_text_->size()));
+    return true;
+}
+
+bool Transport::JsonReader::IsInputAvailable() const
+{
+    return input_text_ || in_.rdbuf()->in_avail() > 0;
+}
+
+void Transport::JsonReader::StartLoadingBase(const json::Dict& serialization_settings, const BaseLoader& load_base)
+{
     ReadSerializationSettings(serialization_settings);
+    base_ = std::async(std::launch::async, load_base, serialization_settings_);
+}
 
-    saved_stat_requests_ = document.GetRoot().AsDict().at("stat_requests").AsArray();
+void Transport::JsonReader::AnswerPendingStatRequests()
+{
+    if (!base_file_)
+    {
+        base_file_ = base_.get();
+    }
+    for (const auto& request : pending_stat_requests_) {
+        AnswerStatRequest(request.AsDict());
+    }
+    pending_stat_requests_.clear();
 }
 
-void Transport::JsonReader::ProcessStatRequests(Routing::TransportRouter& router)
+void Transport::JsonReader::AnswerStatRequest(const json::Dict& request)
 {
-    out_ << "[\n";
-    ReadStatRequests(saved_stat_requests_);
-    out_ << "]\n";
+    if (pool_)
+    {
+        // the request may live in the parser arena, so the task has a copy
+        pool_->Submit([this, request = json::Dict(request)](std::string& response) {
+            ReadResponse(request, response);
+        });
+        return;
+    }
+    ReadResponse(request, response_);
+    WriteResponse(response_);
+    response_.clear();
 }
 
-void Transport::JsonReader::ProcessStatRequests(const Routing::LightTransportRouter& router)
+void Transport::JsonReader::AnswerError(std::string message)
 {
-    out_ << "[\n";
-    ReadStatRequests(saved_stat_requests_, router);
-    out_ << "]\n";
+    if (pool_)
+    {
+        pool_->Submit([this, message = std::move(message)](std::string& response) {
+            PrintJsonError(message, std::nullopt, response);
+        });
+        return;
+    }
+    PrintJsonError(message, std::nullopt, response_);
+    WriteResponse(response_);
+    response_.clear();
+}
+
+void Transport::JsonReader::ReadResponse(const json::Dict& request, std::string& response) const
+{
+    if (!line_mode_)
+    {
+        ReadCachedStatRequest(request, response);
+        return;
+    }
+
+    // a bad request must not stop a long-lived stream
+    const size_t start = response.size();
+    try
+    {
+        ReadCachedStatRequest(request, response);
+    }
+    catch (const std::exception& e)
+    {
+        response.resize(start);
+        std::optional<int> request_id;
+        if (const auto it = request.find("id"sv); it != request.end() && it->second.IsInt())
+        {
+            request_id = it->second.AsInt();
+        }
+        PrintJsonError(e.what(), request_id, response);
+    }
+}
+
+void Transport::JsonReader::WriteResponse(const std::string& response)
+{
+    if (line_mode_)
+    {
+        out_.write(response.data(), response.size());
+        out_.put('\n');
+        return;
+    }
+    if (answered_count_++ != 0)
+    {
+        out_ << (output_format_.compact ? ","sv : ",\n"sv);
+    }
+    out_.write(response.data(), response.size());
+}
+
+void Transport::JsonReader::SetOutputFormat(json::PrintFormat format)
+{
+    output_format_ = format;
+}
+
+void Transport::JsonReader::SetThreadCount(size_t thread_count)
+{
+    thread_count_ = thread_count;
+}
+
+void Transport::JsonReader::SetResponseCacheCapacity(size_t capacity)
+{
+    response_cache_ = capacity != 0 ? std::make_unique<ResponseCache>(capacity) : nullptr;
+}
+
+const ResponseCache* Transport::JsonReader::GetResponseCache() const
+{
+    return response_cache_.get();
 }
 
 std::string Transport::JsonReader::GetSerializationFileName() const
@@ -101,10 +398,14 @@ void Transport::JsonReader::SetRenderSettings(Transport::Rendering::RenderSettin
     render_settings_ = std::move(settings);
 }
 
+Geo::Coordinates ReadCoordinates(const json::Dict& attributes) {
+    return { attributes.at("latitude"s).AsDouble(), attributes.at("longitude"s).AsDouble() };
+}
+
 svg::Color ReadColor(json::Node node) {
     if (node.IsString())
     {
-        return svg::Color(node.AsString());
+        return svg::Color(std::string(node.AsString()));
     }
     else {
         const auto& color_array = node.AsArray();
@@ -152,237 +453,412 @@ void Transport::JsonReader::ReadStop(const json::Dict& attributes) {
 }
 
 void Transport::JsonReader::ReadDistances(const json::Dict& attributes) {
-    const Stop* from = catalogue_.GetStop(attributes.at("name").AsString());
+    PendingDistances request;
+    request.from = std::string(attributes.at("name").AsString());
     for (const auto& [to_name, dist_node] : attributes.at("road_distances").AsDict()) {
-        const Stop* to = catalogue_.GetStop(to_name);
-        catalogue_.SetDistance(from, to, dist_node.AsInt());
+        request.distances.emplace_back(to_name, dist_node.AsInt());
     }
+    pending_base_requests_.push_back(std::move(request));
 }
 
 void Transport::JsonReader::ReadBus(const json::Dict& attributes) {
-    auto& name = attributes.at("name").AsString();
-    bool is_roundtrip = attributes.at("is_roundtrip").AsBool();
-    auto& stop_names = attributes.at("stops").AsArray();
-    vector<const Stop*> stops;
-    for (const auto& stop_name : stop_names) {
-        stops.push_back(catalogue_.GetStop(stop_name.AsString()));
-    }
-    if (!is_roundtrip)
-    {
-        vector<const Stop*> additional(stops.rbegin() + 1, stops.rend());
-        for (const auto stop : additional) {
-            stops.push_back(stop);
-        }
+    PendingBus request;
+    request.name = std::string(attributes.at("name").AsString());
+    request.is_roundtrip = attributes.at("is_roundtrip").AsBool();
+    for (const auto& stop_name : attributes.at("stops").AsArray()) {
+        request.stops.emplace_back(stop_name.AsString());
     }
-    catalogue_.AddBus(name, stops, is_roundtrip);
+    pending_base_requests_.push_back(std::move(request));
 }
 
-void Transport::JsonReader::ReadBaseRequests(const json::Array& base_requests) {
+Transport::JsonReader::ResolvedRequests Transport::JsonReader::ResolvePendingBaseRequests(size_t begin, size_t end) const {
+    ResolvedRequests resolved;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (const auto* request = std::get_if<PendingDistances>(&pending_base_requests_[i]))
+        {
+            const Stop* from = catalogue_.GetStop(request->from);
+            for (const auto& [to_name, distance] : request->distances) {
+                resolved.distances.push_back({ from, catalogue_.GetStop(to_name), distance });
+            }
+            continue;
+        }
 
-    //           
-    // request -  {  -  }
-    for (const auto& request : base_requests) {
-        auto& attributes = request.AsDict();
-        if (attributes.at("type").AsString() == "Stop")
+        const auto& request = std::get<PendingBus>(pending_base_requests_[i]);
+        vector<const Stop*> stops;
+        stops.reserve(request.is_roundtrip ? request.stops.size() : request.stops.size() * 2);
+        for (const auto& stop_name : request.stops) {
+            stops.push_back(catalogue_.GetStop(stop_name));
+        }
+        if (!request.is_roundtrip && !stops.empty())
         {
-            ReadStop(attributes);
+            // the way back, without the last stop repeated; by index, as a range of the vector
+            // itself can't be inserted into it
+            for (size_t j = stops.size() - 1; j > 0; j--)
+            {
+                stops.push_back(stops[j - 1]);
+            }
         }
+        resolved.buses.emplace_back(&request, std::move(stops));
     }
+    return resolved;
+}
 
-    //            
-    for (const auto& request : base_requests) {
-        auto& attributes = request.AsDict();
+void Transport::JsonReader::ReadBaseRequest(const json::Dict& attributes) {
+    const auto& type = attributes.at("type").AsString();
+    if (type == "Stop")
+    {
+        ReadStop(attributes);
+        ReadDistances(attributes);
+    }
+    if (type == "Bus")
+    {
+        ReadBus(attributes);
+    }
+}
 
-        if (attributes.at("type").AsString() == "Stop")
-        {
-            ReadDistances(attributes);
+void Transport::JsonReader::AddPendingBaseRequests() {
+    // the names are resolved in parallel over contiguous ranges of the requests, the catalogue is only
+    // read meanwhile; then the ranges are added one after another, so the result keeps the input order
+    const size_t count = pending_base_requests_.size();
+    const size_t range_count = std::clamp<size_t>(count / MIN_REQUESTS_PER_THREAD, 1, std::max<size_t>(thread_count_, 1));
+    const auto range_begin = [count, range_count](size_t range) {
+        return count * range / range_count;
+    };
+
+    vector<future<ResolvedRequests>> ranges;
+    for (size_t range = 1; range < range_count; range++)
+    {
+        ranges.push_back(std::async(std::launch::async, &JsonReader::ResolvePendingBaseRequests, this,
+            range_begin(range), range_begin(range + 1)));
+    }
+    vector<ResolvedRequests> resolved;
+    resolved.reserve(range_count);
+    resolved.push_back(ResolvePendingBaseRequests(0, range_begin(1)));
+    for (auto& range : ranges) {
+        resolved.push_back(range.get());
+    }
+
+    for (const auto& range : resolved) {
+        for (const auto& [from, to, distance] : range.distances) {
+            catalogue_.SetDistance(from, to, distance);
         }
-        if (attributes.at("type").AsString() == "Bus")
-        {
-            ReadBus(attributes);
+        for (const auto& [request, stops] : range.buses) {
+            catalogue_.AddBus(request->name, stops, request->is_roundtrip);
         }
     }
+
+    pending_base_requests_.clear();
+    pending_base_requests_.shrink_to_fit();
+
+    catalogue_.BuildIndexes();
+}
+
+void Transport::JsonReader::ReadBaseRequests(const json::Array& base_requests) {
+
+    //           
+    // request -  {  -  }
+    for (const auto& request : base_requests) {
+        ReadBaseRequest(request.AsDict());
+    }
+
+    //            
+    AddPendingBaseRequests();
 }
 
 void Transport::JsonReader::ReadRouterSettings(const json::Dict& attributes)
 {
     routing_settings_.bus_wait_time = attributes.at("bus_wait_time").AsInt();
     routing_settings_.bus_velocity = attributes.at("bus_velocity").AsInt();
+    if (const auto it = attributes.find("walking_velocity"s); it != attributes.end())
+    {
+        routing_settings_.walking_velocity = it->second.AsDouble();
+    }
+    if (const auto it = attributes.find("walking_distance"s); it != attributes.end())
+    {
+        routing_settings_.walking_distance = it->second.AsDouble();
+    }
 }
 
 void Transport::JsonReader::ReadSerializationSettings(const json::Dict& attributes)
 {
-    serialization_settings_ = attributes.at("file").AsString();
+    serialization_settings_ = std::string(attributes.at("file").AsString());
 }
 
-void Transport::JsonReader::PrintJsonStopInfo(const Transport::StopInfo& info, int request_id) {
+void Transport::JsonReader::PrintJsonStopInfo(const Transport::StopInfo& info, int request_id, std::string& response) const {
 
-	if (!info.exists)
-	{
-		json::Print(
-			json::Document{
-				json::Builder{}.StartDict()
-			.Key("request_id"s).Value(request_id)
-			.Key("error_message"s).Value("not found"s)
-			.EndDict().Build()
-			},
-			out_
-		);
-		out_ << endl;
-        return;
+    json::Writer writer(response, output_format_);
+    if (!info.exists)
+    {
+        writer.StartDict()
+            .Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(request_id)
+            .EndDict();
     }
-    json::Builder builder;
-    auto b = builder.StartDict()
-        .Key("request_id"s).Value(request_id)
-        .Key("buses"s).StartArray();
-
-    if (info.buses)
+    else
     {
-        for (const auto& bus : *info.buses) {
-            b.Value(bus->name);
+        writer.StartDict()
+            .Key("buses"sv).StartArray();
+        for (const auto& bus : info.buses) {
+            writer.Value(bus->name);
         }
+        writer.EndArray()
+            .Key("request_id"sv).Value(request_id)
+            .EndDict();
     }
-
-    json::Print(json::Document{ b.EndArray().EndDict().Build()},out_ );
-    out_ << endl;
-    return;
+    EndResponse(response);
 }
 
-void Transport::JsonReader::PrintJsonBusInfo(const Transport::BusInfo& info, int request_id) {
+void Transport::JsonReader::PrintJsonBusInfo(const Transport::BusInfo& info, int request_id, std::string& response) const {
 
+    json::Writer writer(response, output_format_);
     if (!info.exists)
     {
-        json::Print(
-            json::Document{
-                json::Builder{}.StartDict()
-            .Key("request_id"s).Value(request_id)
-            .Key("error_message"s).Value("not found"s)
-            .EndDict().Build()
-            },
-            out_
-        );
-        out_ << endl;
-        return;
+        writer.StartDict()
+            .Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(request_id)
+            .EndDict();
     }
-
-    json::Print(
-        json::Document{
-            json::Builder{}.StartDict()
-        .Key("request_id"s).Value(request_id)
-        .Key("curvature"s).Value(double(info.real_length) / info.geo_length)
-        .Key("route_length").Value(info.real_length)
-        .Key("stop_count").Value(int(info.stops_count))
-        .Key("unique_stop_count").Value(int(info.unique_stops))
-        .EndDict().Build()
-        },
-        out_
-    );
-    out_ << endl;
+    else
+    {
+        writer.StartDict()
+            .Key("curvature"sv).Value(double(info.real_length) / info.geo_length)
+            .Key("request_id"sv).Value(request_id)
+            .Key("route_length"sv).Value(info.real_length)
+            .Key("stop_count"sv).Value(int(info.stops_count))
+            .Key("unique_stop_count"sv).Value(int(info.unique_stops))
+            .EndDict();
+    }
+    EndResponse(response);
 }
 
-void Transport::JsonReader::PrintJsonMap(int request_id)
+void Transport::JsonReader::PrintJsonMap(int request_id, std::string& response) const
 {
-    ostringstream map_ostream;
-    RenderCatalogue(catalogue_, render_settings_, map_ostream);
-
-    json::Print(
-        json::Document{
-            json::Builder{}.StartDict()
-        .Key("request_id"s).Value(request_id)
-        .Key("map"s).Value(map_ostream.str())
-        .EndDict().Build()
-        },
-        out_
-    );
-    out_ << endl;
+    json::Writer writer(response, output_format_);
+    writer.StartDict().Key("map"sv);
+    if (base_file_ && !base_file_->GetMap().json_escaped_svg.empty())
+    {
+        // make_base has rendered the map into the base
+        writer.EscapedValue(base_file_->GetMap().json_escaped_svg);
+    }
+    else
+    {
+        ostringstream map_ostream;
+        // the base stores the render settings of process_requests
+        RenderCatalogue(catalogue_, base_file_ ? base_file_->GetRenderSettings() : render_settings_, map_ostream);
+        writer.Value(map_ostream.str());
+    }
+    writer.Key("request_id"sv).Value(request_id).EndDict();
+    EndResponse(response);
 }
 
-void Transport::JsonReader::PrintJsonRoute(const string_view from, const string_view to, int request_id, Routing::TransportRouter& router)
+void Transport::JsonReader::PrintJsonRoute(const string_view from, const string_view to, int request_id, Routing::TransportRouter& router, std::string& response)
 {
     auto route_info = router.BuildRoute(from, to);
 
-    json::Builder builder;
-    auto b = builder.StartDict()
-        .Key("request_id"s).Value(request_id);
+    json::Writer writer(response, output_format_);
+    writer.StartDict();
     if (!route_info)
     {
-        b.Key("error_message"s).Value("not found"s);
+        writer.Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(request_id);
     }
     else
     {
-        auto items = b.Key("total_time"s).Value(route_info.value().weight)
-            .Key("items"s).StartArray();
-
-        auto PrintItem = [&](graph::EdgeId id) {
-            json::Builder builder;
-            auto c = builder.StartDict();
-            auto info = router.GetEdgeInfo(id);
-            if (info.span_count == 0)
-            {
-                c.Key("type"s).Value("Wait"s)
-                    .Key("stop_name"s).Value(info.name);
-            }
-            else
-            {
-                c.Key("type"s).Value("Bus"s)
-                    .Key("bus"s).Value(info.name)
-                    .Key("span_count").Value(int(info.span_count));
-            }
-            c.Key("time"s).Value(info.weight);
-            return c.EndDict().Build();
-        };
-        
-        for (const auto& edge_id : route_info.value().edges)
-        {
-            items.Value(PrintItem(edge_id));
+        writer.Key("items"sv).StartArray();
+        for (const auto edge_id : route_info->edges) {
+            WriteJsonRouteItem(writer, router.GetEdgeInfo(edge_id));
         }
-        items.EndArray();
+        writer.EndArray()
+            .Key("request_id"sv).Value(request_id)
+            .Key("total_time"sv).Value(route_info->weight);
     }
-	json::Print(json::Document(b.EndDict().Build()), out_);
+    writer.EndDict();
 }
 
-void Transport::JsonReader::PrintJsonRoute(const std::string_view from, const std::string_view to, int request_id, const Routing::LightTransportRouter& router)
+void Transport::JsonReader::PrintJsonRoute(Geo::Coordinates from, Geo::Coordinates to, int request_id, const Routing::LightTransportRouter& router, std::string& response) const
 {
     auto route_info = router.BuildRoute(from, to);
 
-    json::Builder builder;
-    auto b = builder.StartDict()
-        .Key("request_id"s).Value(request_id);
+    json::Writer writer(response, output_format_);
+    writer.StartDict();
     if (!route_info)
     {
-        b.Key("error_message"s).Value("not found"s);
+        writer.Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(request_id)
+            .EndDict();
+        return;
+    }
+
+    writer.Key("items"sv).StartArray();
+    if (!route_info->first_stop)
+    {
+        writer.StartDict()
+            .Key("time"sv).Value(route_info->walk_to_time)
+            .Key("type"sv).Value("Walk"sv)
+            .EndDict();
     }
     else
     {
-        auto items = b.Key("total_time"s).Value(route_info.value().weight)
-            .Key("items"s).StartArray();
+        writer.StartDict()
+            .Key("time"sv).Value(route_info->walk_to_time)
+            .Key("to_stop"sv).Value(route_info->first_stop->name)
+            .Key("type"sv).Value("Walk"sv)
+            .EndDict();
+
+        for (const auto edge_id : route_info->edges) {
+            WriteJsonRouteItem(writer, router.GetEdgeInfo(edge_id));
+        }
 
-        auto PrintItem = [&](graph::EdgeId id) {
-            json::Builder builder;
-            auto c = builder.StartDict();
-            auto info = router.GetEdgeInfo(id);
-            if (info.span_count == 0)
-            {
-                c.Key("type"s).Value("Wait"s)
-                    .Key("stop_name"s).Value(info.name);
-            }
-            else
-            {
-                c.Key("type"s).Value("Bus"s)
-                    .Key("bus"s).Value(info.name)
-                    .Key("span_count").Value(int(info.span_count));
-            }
-            c.Key("time"s).Value(info.weight);
-            return c.EndDict().Build();
-        };
+        writer.StartDict()
+            .Key("from_stop"sv).Value(route_info->last_stop->name)
+            .Key("time"sv).Value(route_info->walk_from_time)
+            .Key("type"sv).Value("Walk"sv)
+            .EndDict();
+    }
+    writer.EndArray()
+        .Key("request_id"sv).Value(request_id)
+        .Key("total_time"sv).Value(route_info->weight)
+        .EndDict();
+}
 
-        for (const auto& edge_id : route_info.value().edges)
-        {
-            items.Value(PrintItem(edge_id));
+void Transport::JsonReader::PrintJsonSuggest(const json::Dict& attributes, int request_id, std::string& response) const
+{
+    const auto& query = attributes.at("query"s).AsString();
+    size_t count = DEFAULT_SUGGEST_COUNT;
+    if (const auto it = attributes.find("count"s); it != attributes.end())
+    {
+        count = static_cast<size_t>(std::max(it->second.AsInt(), 0));
+    }
+    size_t max_errors = 0;
+    if (const auto it = attributes.find("max_errors"s); it != attributes.end())
+    {
+        max_errors = static_cast<size_t>(std::max(it->second.AsInt(), 0));
+    }
+
+    json::Writer writer(response, output_format_);
+    writer.StartDict()
+        .Key("buses"sv).StartArray();
+    for (const auto bus : catalogue_.SuggestBuses(query, count, max_errors)) {
+        writer.Value(bus->name);
+    }
+    writer.EndArray()
+        .Key("request_id"sv).Value(request_id)
+        .Key("stops"sv).StartArray();
+    for (const auto stop : catalogue_.SuggestStops(query, count, max_errors)) {
+        writer.Value(stop->name);
+    }
+    writer.EndArray()
+        .EndDict();
+    EndResponse(response);
+}
+
+std::vector<NearbyStop> Transport::JsonReader::FindNearestStops(const json::Dict& attributes) const
+{
+    const Geo::Coordinates center = ReadCoordinates(attributes);
+
+    // "count" nearest stops, optionally within "radius" meters, or all stops within "radius" meters
+    std::optional<double> radius;
+    if (const auto it = attributes.find("radius"s); it != attributes.end())
+    {
+        radius = it->second.AsDouble();
+    }
+    if (const auto it = attributes.find("count"s); it != attributes.end())
+    {
+        return catalogue_.FindNearestStops(center, static_cast<size_t>(std::max(it->second.AsInt(), 0)), radius);
+    }
+    if (!radius)
+    {
+        throw std::invalid_argument("NearestStops request needs radius or count"s);
+    }
+    return catalogue_.FindStopsInRadius(center, *radius);
+}
+
+void Transport::JsonReader::PrintJsonNearestStops(const std::vector<NearbyStop>& stops, int request_id, std::string& response) const
+{
+    json::Writer writer(response, output_format_);
+    writer.StartDict()
+        .Key("request_id"sv).Value(request_id)
+        .Key("stops"sv).StartArray();
+    for (const auto& nearby : stops) {
+        writer.StartDict()
+            .Key("distance"sv).Value(nearby.distance)
+            .Key("name"sv).Value(nearby.stop->name)
+            .EndDict();
+    }
+    writer.EndArray()
+        .EndDict();
+    EndResponse(response);
+}
+
+void Transport::JsonReader::PrintJsonError(std::string_view message, std::optional<int> request_id, std::string& response) const
+{
+    json::Writer writer(response, output_format_);
+    writer.StartDict()
+        .Key("error_message"sv).Value(message);
+    if (request_id)
+    {
+        writer.Key("request_id"sv).Value(*request_id);
+    }
+    writer.EndDict();
+    EndResponse(response);
+}
+
+void Transport::JsonReader::EndResponse(std::string& response) const
+{
+    if (!output_format_.compact)
+    {
+        response += '\n';
+    }
+}
+
+void Transport::JsonReader::FlushResponse()
+{
+    out_.write(response_.data(), response_.size());
+    response_.clear();
+}
+
+void Transport::JsonReader::PrintJsonRoute(const std::string_view from, const std::string_view to, int request_id, const Routing::LightTransportRouter& router, std::string& response) const
+{
+    auto route_info = router.BuildRoute(from, to);
+
+    json::Writer writer(response, output_format_);
+    writer.StartDict();
+    if (!route_info)
+    {
+        writer.Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(request_id);
+    }
+    else
+    {
+        writer.Key("items"sv).StartArray();
+        for (const auto edge_id : route_info->edges) {
+            WriteJsonRouteItem(writer, router.GetEdgeInfo(edge_id));
         }
-        items.EndArray();
+        writer.EndArray()
+            .Key("request_id"sv).Value(request_id)
+            .Key("total_time"sv).Value(route_info->weight);
     }
-    json::Print(json::Document(b.EndDict().Build()), out_);
+    writer.EndDict();
+}
+
+void Transport::JsonReader::WriteJsonRouteItem(json::Writer& writer, const Routing::EdgeInfo& info) const
+{
+    writer.StartDict();
+    if (info.span_count == 0)
+    {
+        writer.Key("stop_name"sv).Value(info.name)
+            .Key("time"sv).Value(info.weight)
+            .Key("type"sv).Value("Wait"sv);
+    }
+    else
+    {
+        writer.Key("bus"sv).Value(info.name)
+            .Key("span_count"sv).Value(int(info.span_count))
+            .Key("time"sv).Value(info.weight)
+            .Key("type"sv).Value("Bus"sv);
+    }
+    writer.EndDict();
 }
 
 void Transport::JsonReader::ReadStatRequests(const json::Array& stat_requests) {
@@ -394,66 +870,161 @@ void Transport::JsonReader::ReadStatRequests(const json::Array& stat_requests) {
     {
         if (i != 0)
         {
-            out_ << ",\n";
+            out_ << (output_format_.compact ? ","sv : ",\n"sv);
         }
         auto& attributes = stat_requests[i].AsDict();
 
-        string type = attributes.at("type").AsString();
+        const auto& type = attributes.at("type").AsString();
         int request_id = attributes.at("id").AsInt();
         if (type == "Stop")
         {
             auto& name = attributes.at("name").AsString();
-            PrintJsonStopInfo(catalogue_.GetStopInfo(catalogue_.GetStop(name)), request_id);
+            PrintJsonStopInfo(catalogue_.GetStopInfo(catalogue_.GetStop(name)), request_id, response_);
         }
         if (type == "Bus")
         {
             auto& name = attributes.at("name").AsString();
-            PrintJsonBusInfo(catalogue_.GetBusInfo(catalogue_.GetBus(name)), request_id);
+            PrintJsonBusInfo(catalogue_.GetBusInfo(catalogue_.GetBus(name)), request_id, response_);
         }
         if (type == "Map")
         {
-            PrintJsonMap(request_id);
+            PrintJsonMap(request_id, response_);
+        }
+        if (type == "NearestStops")
+        {
+            PrintJsonNearestStops(FindNearestStops(attributes), request_id, response_);
+        }
+        if (type == "Suggest")
+        {
+            PrintJsonSuggest(attributes, request_id, response_);
         }
         /*if (type == "Route")
         {
             auto& from = attributes.at("from").AsString();
             auto& to = attributes.at("to").AsString();
-            PrintJsonRoute(from, to, request_id, router);
+            PrintJsonRoute(from, to, request_id, router, response_);
         }*/
+        FlushResponse();
     }
 }
 
-void Transport::JsonReader::ReadStatRequests(const json::Array& stat_requests, const Routing::LightTransportRouter& router)
-{
-    for (size_t i = 0; i < stat_requests.size(); i++)
-    {
-        if (i != 0)
-        {
-            out_ << ",\n";
-        }
-        auto& attributes = stat_requests[i].AsDict();
+void AppendRequestKey(const json::Node& node, std::string& key);
 
-        string type = attributes.at("type").AsString();
-        int request_id = attributes.at("id").AsInt();
-        if (type == "Stop")
+// members are in key order, skipped_name is left out
+void AppendRequestKey(const json::Dict& dict, std::string& key, std::optional<std::string_view> skipped_name = std::nullopt) {
+    key += '{';
+    for (const auto& [name, value] : dict) {
+        if (name == skipped_name)
         {
-            auto& name = attributes.at("name").AsString();
-            PrintJsonStopInfo(catalogue_.GetStopInfo(catalogue_.GetStop(name)), request_id);
-        }
-        if (type == "Bus")
-        {
-            auto& name = attributes.at("name").AsString();
-            PrintJsonBusInfo(catalogue_.GetBusInfo(catalogue_.GetBus(name)), request_id);
+            continue;
         }
-        if (type == "Map")
-        {
-            PrintJsonMap(request_id);
+        key.append(std::to_string(name.size())).append(1, ':').append(name);
+        AppendRequestKey(value, key);
+    }
+    key += '}';
+}
+
+// appends a text which is equal for equal nodes only: values are tagged with their types,
+// and strings with their lengths, so no two different requests give the same key
+void AppendRequestKey(const json::Node& node, std::string& key) {
+    if (node.IsDict())
+    {
+        AppendRequestKey(node.AsDict(), key);
+    }
+    else if (node.IsArray())
+    {
+        key += '[';
+        for (const auto& item : node.AsArray()) {
+            AppendRequestKey(item, key);
         }
-        if (type == "Route")
+        key += ']';
+    }
+    else if (node.IsString())
+    {
+        const auto& value = node.AsString();
+        key.append(1, 's').append(std::to_string(value.size())).append(1, ':').append(value);
+    }
+    else if (node.IsInt())
+    {
+        key.append(1, 'i').append(std::to_string(node.AsInt())).append(1, ';');
+    }
+    else if (node.IsPureDouble())
+    {
+        char buffer[32];
+        const int length = std::snprintf(buffer, sizeof(buffer), "d%.17g;", node.AsDouble());
+        key.append(buffer, length);
+    }
+    else if (node.IsBool())
+    {
+        key += node.AsBool() ? 't' : 'f';
+    }
+    else
+    {
+        key += 'n';
+    }
+}
+
+void Transport::JsonReader::ReadCachedStatRequest(const json::Dict& attributes, std::string& response) const
+{
+    if (!response_cache_)
+    {
+        ReadStatRequest(attributes, response);
+        return;
+    }
+
+    // the key is the request without its id
+    std::string key;
+    AppendRequestKey(attributes, key, "id"sv);
+
+    const int request_id = attributes.at("id").AsInt();
+    if (response_cache_->Find(key, request_id, response))
+    {
+        return;
+    }
+    const size_t start = response.size();
+    ReadStatRequest(attributes, response);
+    response_cache_->Store(std::move(key), std::string_view(response).substr(start), request_id);
+}
+
+void Transport::JsonReader::ReadStatRequest(const json::Dict& attributes, std::string& response) const
+{
+    const auto& type = attributes.at("type").AsString();
+    int request_id = attributes.at("id").AsInt();
+    if (type == "Stop")
+    {
+        auto& name = attributes.at("name").AsString();
+        PrintJsonStopInfo(catalogue_.GetStopInfo(catalogue_.GetStop(name)), request_id, response);
+    }
+    if (type == "Bus")
+    {
+        auto& name = attributes.at("name").AsString();
+        PrintJsonBusInfo(catalogue_.GetBusInfo(catalogue_.GetBus(name)), request_id, response);
+    }
+    if (type == "Map")
+    {
+        PrintJsonMap(request_id, response);
+    }
+    if (type == "NearestStops")
+    {
+        PrintJsonNearestStops(FindNearestStops(attributes), request_id, response);
+    }
+    if (type == "Suggest")
+    {
+        PrintJsonSuggest(attributes, request_id, response);
+    }
+    if (type == "Route")
+    {
+        // the router is read from the base by the first route
+        const auto& router = base_file_->GetRouter();
+        // points are given as {"latitude": ..., "longitude": ...} instead of stop names
+        if (attributes.at("from").IsDict())
         {
-            auto& from = attributes.at("from").AsString();
-            auto& to = attributes.at("to").AsString();
-            PrintJsonRoute(from, to, request_id, router);
+            PrintJsonRoute(ReadCoordinates(attributes.at("from").AsDict()),
+                ReadCoordinates(attributes.at("to").AsDict()), request_id, router, response);
+            return;
         }
+        auto& from = attributes.at("from").AsString();
+        auto& to = attributes.at("to").AsString();
+        PrintJsonRoute(from, to, request_id, router, response);
     }
 }
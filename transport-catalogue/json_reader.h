@@ -1,25 +1,78 @@
 #pragma once
 
 #include "json.h"
+#include "json_writer.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
 #include "router.h"
+#include "ordered_worker_pool.h"
+#include "response_cache.h"
 
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace serialization {
+	class BaseFile;
+}
 
 namespace Transport {
 
 	class JsonReader {
 	public:
+		// names suggested for each of stops and buses when a Suggest request has no count
+		static constexpr size_t DEFAULT_SUGGEST_COUNT = 10;
+
+		// fewer pending base requests per thread are not worth starting a thread
+		static constexpr size_t MIN_REQUESTS_PER_THREAD = 4096;
+
+		static constexpr size_t LINE_FLUSH_BATCH = 256;
+
 		JsonReader(TransportCatalogue& catalogue, std::istream& in = std::cin, std::ostream& out = std::cout)
 			: catalogue_(catalogue), in_(in), out_(out) {}
+		~JsonReader();
+
+		// loads the catalogue from the file, the router and the render settings are got from
+		// the returned base when a request needs them
+		using BaseLoader = std::function<std::unique_ptr<serialization::BaseFile>(const std::string& filename)>;
+
+		// the input is parsed from text instead of the stream, the text must outlive the reader
+		void SetInput(std::string_view text);
 
 		void ReadInput();
 		void ReadMakeBaseInput();
-		void ReadProcessRequest();
-		void ProcessStatRequests(Routing::TransportRouter& router);
-		void ProcessStatRequests(const Routing::LightTransportRouter& router);
+
+		// reads the process_requests input and prints the answers while it is parsed;
+		// load_base runs in another thread, concurrently with the parsing
+		void ProcessRequests(const BaseLoader& load_base);
+
+		// reads the settings from the first line and a stat request from every next one, and writes
+		// the response to each request on a line of its own; the output is flushed after every
+		// LINE_FLUSH_BATCH responses and whenever the input has to be waited for.
+		// A bad request is answered with error_message instead of stopping the stream
+		void ProcessRequestLines(const BaseLoader& load_base);
+
+		// make_base resolves the stops of base requests and process_requests answers stat requests
+		// in thread_count threads, the result is the same
+		void SetThreadCount(size_t thread_count);
+
+		// layout of the responses, the line mode makes it compact
+		void SetOutputFormat(json::PrintFormat format);
+
+		// process_requests reuses the responses to equal requests, keeping up to capacity bytes of them;
+		// 0 turns the cache off
+		void SetResponseCacheCapacity(size_t capacity);
+		// nullptr if the cache is off
+		const ResponseCache* GetResponseCache() const;
 
 		std::string GetSerializationFileName() const;
 		const Rendering::RenderSettings& GetRenderSettings() const;
@@ -27,22 +80,96 @@ namespace Transport {
 		void SetRenderSettings(Transport::Rendering::RenderSettings settings);
 
 	private:
+		// parses the input text if it is set, the input stream otherwise
+		void ParseInput(json::Handler& handler);
+
 		void ReadRenderSettings(const json::Dict& attributes);
 		void ReadBaseRequests(const json::Array& base_requests);
 		void ReadRouterSettings(const json::Dict& attributes);
 		void ReadStatRequests(const json::Array& stat_requests);
-		void ReadStatRequests(const json::Array& stat_requests, const Routing::LightTransportRouter& router);
+		// appends the response to the request to response; reads the base only, so it may run in several threads at once
+		void ReadStatRequest(const json::Dict& attributes, std::string& response) const;
+		// ReadStatRequest through the response cache, the base must be loaded
+		void ReadCachedStatRequest(const json::Dict& attributes, std::string& response) const;
 		void ReadSerializationSettings(const json::Dict& attributes);
 
+		// distances and buses refer to stops which may come later in the input,
+		// so they are kept in this compact form until all the stops are added
+		struct PendingDistances
+		{
+			std::string from;
+			std::vector<std::pair<std::string, int>> distances;
+		};
+
+		struct PendingBus
+		{
+			std::string name;
+			std::vector<std::string> stops;
+			bool is_roundtrip = false;
+		};
+
+		void StartLoadingBase(const json::Dict& serialization_settings, const BaseLoader& load_base);
+
+		// waits for the base on the first call
+		void AnswerPendingStatRequests();
+		// answers at once or passes the request to the worker pool, the base must be loaded
+		void AnswerStatRequest(const json::Dict& request);
+		// answers a request which can't be read with an error in its turn
+		void AnswerError(std::string message);
+		// ReadCachedStatRequest which in the line mode answers with an error instead of throwing
+		void ReadResponse(const json::Dict& request, std::string& response) const;
+
+		// the next line of the input without the line break, false at the end
+		bool ReadLine(std::string_view& line);
+		// false if reading the input may block
+		bool IsInputAvailable() const;
+		// writes the response with its separator
+		void WriteResponse(const std::string& response);
+
+		// adds a stop at once, queues its distances or a bus
+		void ReadBaseRequest(const json::Dict& attributes);
+
+		// adds the queued distances and buses in input order once all the stops are read
+		void AddPendingBaseRequests();
+
 		void ReadStop(const json::Dict& attributes);
 		void ReadDistances(const json::Dict& attributes);
 		void ReadBus(const json::Dict& attributes);
 
-		void PrintJsonStopInfo(const StopInfo& info, int request_id);
-		void PrintJsonBusInfo(const BusInfo& info, int request_id);
-		void PrintJsonMap(int request_id);
-		void PrintJsonRoute(const std::string_view from, const std::string_view to, int request_id, Routing::TransportRouter& router);
-		void PrintJsonRoute(const std::string_view from, const std::string_view to, int request_id, const Routing::LightTransportRouter& router);
+		// the stops of a range of the pending requests
+		struct ResolvedRequests
+		{
+			std::vector<std::tuple<const Stop*, const Stop*, int>> distances;
+			// the bus request and its full route
+			std::vector<std::pair<const PendingBus*, std::vector<const Stop*>>> buses;
+		};
+
+		// reads the catalogue only, so ranges may be resolved in several threads at once
+		ResolvedRequests ResolvePendingBaseRequests(size_t begin, size_t end) const;
+
+		std::vector<NearbyStop> FindNearestStops(const json::Dict& attributes) const;
+
+		// the PrintJson functions append the response to response
+		void PrintJsonStopInfo(const StopInfo& info, int request_id, std::string& response) const;
+		void PrintJsonBusInfo(const BusInfo& info, int request_id, std::string& response) const;
+		void PrintJsonMap(int request_id, std::string& response) const;
+		void PrintJsonNearestStops(const std::vector<NearbyStop>& stops, int request_id, std::string& response) const;
+		void PrintJsonSuggest(const json::Dict& attributes, int request_id, std::string& response) const;
+		void WriteJsonRouteItem(json::Writer& writer, const Routing::EdgeInfo& info) const;
+
+		// request_id is left out if the request has no id
+		void PrintJsonError(std::string_view message, std::optional<int> request_id, std::string& response) const;
+		// the line break after a response in the indented output
+		void EndResponse(std::string& response) const;
+
+		// writes the response accumulated in response_ to the output
+		void FlushResponse();
+		void PrintJsonRoute(const std::string_view from, const std::string_view to, int request_id, Routing::TransportRouter& router,
+			std::string& response);
+		void PrintJsonRoute(const std::string_view from, const std::string_view to, int request_id, const Routing::LightTransportRouter& router,
+			std::string& response) const;
+		void PrintJsonRoute(Geo::Coordinates from, Geo::Coordinates to, int request_id, const Routing::LightTransportRouter& router,
+			std::string& response) const;
 
 	private:
 		Rendering::RenderSettings render_settings_;
@@ -50,8 +177,32 @@ namespace Transport {
 		std::string serialization_settings_;
 		TransportCatalogue& catalogue_;
 		std::istream& in_;
+		// the rest of the input text
+		std::optional<std::string_view> input_text_;
+		// the current line of the input stream
+		std::string line_;
 		std::ostream& out_;
 
-		json::Array saved_stat_requests_;
+		// reused for every response, so its capacity is allocated once
+		std::string response_;
+		// one response per line instead of an array
+		bool line_mode_ = false;
+		// the line mode is always compact
+		json::PrintFormat output_format_;
+
+		// stat requests parsed but not answered yet
+		json::Array pending_stat_requests_;
+		size_t answered_count_ = 0;
+
+		std::future<std::unique_ptr<serialization::BaseFile>> base_;
+		std::unique_ptr<serialization::BaseFile> base_file_;
+
+		// stat requests are answered by the pool if there is more than one thread
+		size_t thread_count_ = 1;
+		std::optional<OrderedWorkerPool> pool_;
+
+		std::unique_ptr<ResponseCache> response_cache_ = std::make_unique<ResponseCache>();
+
+		std::vector<std::variant<PendingDistances, PendingBus>> pending_base_requests_;
 	};
 }
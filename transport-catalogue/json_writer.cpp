@@ -0,0 +1,184 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <stdexcept>
+
+using namespace json;
+using namespace std;
+
+json::Writer& json::Writer::StartDict()
+{
+	Open('{', true);
+	return *this;
+}
+
+json::Writer& json::Writer::EndDict()
+{
+	Close('}', true);
+	return *this;
+}
+
+json::Writer& json::Writer::StartArray()
+{
+	Open('[', false);
+	return *this;
+}
+
+json::Writer& json::Writer::EndArray()
+{
+	Close(']', false);
+	return *this;
+}
+
+json::Writer& json::Writer::Key(std::string_view key)
+{
+	if (depth_ == 0 || !stack_[depth_ - 1].is_dict)
+	{
+		throw logic_error("Key outside of a dict"s);
+	}
+	auto& level = stack_[depth_ - 1];
+	if (!level.empty)
+	{
+		buffer_ += ',';
+	}
+	level.empty = false;
+	WriteIndent(depth_);
+	WriteString(key);
+	buffer_ += format_.compact ? ":"sv : ": "sv;
+	return *this;
+}
+
+json::Writer& json::Writer::Value(std::string_view value)
+{
+	BeforeValue();
+	WriteString(value);
+	return *this;
+}
+
+json::Writer& json::Writer::EscapedValue(std::string_view escaped)
+{
+	BeforeValue();
+	buffer_ += '"';
+	buffer_ += escaped;
+	buffer_ += '"';
+	return *this;
+}
+
+json::Writer& json::Writer::Value(const char* value)
+{
+	return Value(std::string_view(value));
+}
+
+json::Writer& json::Writer::Value(int value)
+{
+	BeforeValue();
+	char chars[16];
+	const auto result = to_chars(begin(chars), end(chars), value);
+	buffer_.append(chars, result.ptr);
+	return *this;
+}
+
+json::Writer& json::Writer::Value(double value)
+{
+	BeforeValue();
+	char chars[MAX_DOUBLE_CHARS];
+	buffer_.append(chars, FormatDouble(value, format_.round_trip_doubles, chars));
+	return *this;
+}
+
+json::Writer& json::Writer::Value(bool value)
+{
+	BeforeValue();
+	buffer_ += value ? "true"sv : "false"sv;
+	return *this;
+}
+
+json::Writer& json::Writer::Null()
+{
+	BeforeValue();
+	buffer_ += "null"sv;
+	return *this;
+}
+
+void json::Writer::BeforeValue()
+{
+	// a dict member is already prefixed by Key()
+	if (depth_ == 0 || stack_[depth_ - 1].is_dict)
+	{
+		return;
+	}
+	auto& level = stack_[depth_ - 1];
+	if (!level.empty)
+	{
+		buffer_ += ',';
+	}
+	level.empty = false;
+	WriteIndent(depth_);
+}
+
+void json::Writer::Open(char bracket, bool is_dict)
+{
+	if (depth_ == MAX_DEPTH)
+	{
+		throw logic_error("JSON nesting is too deep"s);
+	}
+	BeforeValue();
+	buffer_ += bracket;
+	stack_[depth_++] = Level{ is_dict };
+}
+
+void json::Writer::Close(char bracket, bool is_dict)
+{
+	if (depth_ == 0 || stack_[depth_ - 1].is_dict != is_dict)
+	{
+		throw logic_error("Closing a container which is not open"s);
+	}
+	--depth_;
+	if (stack_[depth_].empty && !format_.compact)
+	{
+		// Print puts an empty line into an empty container
+		buffer_ += '\n';
+	}
+	WriteIndent(depth_);
+	buffer_ += bracket;
+}
+
+void json::Writer::WriteIndent(size_t depth)
+{
+	if (format_.compact)
+	{
+		return;
+	}
+	buffer_ += '\n';
+	buffer_.append(depth * 4, ' ');
+}
+
+void json::AppendEscaped(std::string_view value, std::string& out)
+{
+	for (const char c : value) {
+		switch (c)
+		{
+		case '\r':
+			out += "\\r"sv;
+			break;
+		case '\n':
+			out += "\\n"sv;
+			break;
+		case '"':
+			[[fallthrough]];
+		case '\\':
+			out += '\\';
+			[[fallthrough]];
+		default:
+			out += c;
+			break;
+		}
+	}
+}
+
+void json::Writer::WriteString(std::string_view value)
+{
+	buffer_ += '"';
+	AppendEscaped(value, buffer_);
+	buffer_ += '"';
+}
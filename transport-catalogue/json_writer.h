@@ -0,0 +1,58 @@
+#pragma once
+
+#include "json.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+	// appends value escaped as in a JSON string, without the quotes
+	void AppendEscaped(std::string_view value, std::string& out);
+
+	// Appends a value to a string in exactly the format of json::Print, without building nodes.
+	// Print orders dict members by key, so the keys of a dict must be written in ascending order.
+	// The format may make the text compact and doubles exact, as in Print.
+	class Writer {
+	public:
+		static constexpr size_t MAX_DEPTH = 32;
+
+		explicit Writer(std::string& buffer, PrintFormat format = {})
+			: buffer_(buffer), format_(format) {}
+
+		Writer& StartDict();
+		Writer& EndDict();
+		Writer& StartArray();
+		Writer& EndArray();
+		Writer& Key(std::string_view key);
+
+		Writer& Value(std::string_view value);
+		// a string value which is escaped already, as AppendEscaped does
+		Writer& EscapedValue(std::string_view escaped);
+		Writer& Value(const char* value);
+		Writer& Value(int value);
+		Writer& Value(double value);
+		Writer& Value(bool value);
+		Writer& Null();
+
+	private:
+		struct Level {
+			bool is_dict = false;
+			bool empty = true;
+		};
+
+		void BeforeValue();
+		void Open(char bracket, bool is_dict);
+		void Close(char bracket, bool is_dict);
+		// a line break and the indent of depth, nothing for a compact writer
+		void WriteIndent(size_t depth);
+		void WriteString(std::string_view value);
+
+	private:
+		std::string& buffer_;
+		PrintFormat format_;
+		std::array<Level, MAX_DEPTH> stack_;
+		size_t depth_ = 0;
+	};
+}
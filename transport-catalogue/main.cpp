@@ -1,46 +1,171 @@
-﻿#include <fstream>
+﻿#include <algorithm>
+#include <charconv>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <thread>
 
 #include "transport_catalogue.h"
 #include "json_reader.h"
 #include "serialization.h"
+#include "flat_base.h"
+#include "counting_resource.h"
+#include "mapped_file.h"
 
 using namespace std;
 
 using namespace Transport;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests] [--arena] [--input FILE] [--threads N] [--cache-mb N] [--cache-stats] [--ndjson] [--compact] [--round-trip-doubles] [--flat-base]\n"sv;
+}
+
+struct Options {
+    // build the whole base in a monotonic arena and report its size to stderr
+    bool use_arena = false;
+    // read the input from this file mapped into memory instead of the standard input
+    std::optional<std::string> input_file;
+    // threads resolving base requests and answering stat requests, 0 for one per core
+    size_t thread_count = 1;
+    // memory for the responses to repeated stat requests, 0 turns the cache off
+    size_t cache_mb = ResponseCache::DEFAULT_CAPACITY >> 20;
+    // report the cache hits and misses to stderr
+    bool print_cache_stats = false;
+    // process_requests reads a request and writes a response per line
+    bool ndjson = false;
+    // layout of the responses
+    json::PrintFormat output_format;
+    // make_base writes the base in the flat format, which process_requests maps and uses in place
+    bool flat_base = false;
+};
+
+// reads a whole option value as a number
+bool ParseNumber(std::string_view value, size_t& number) {
+    return std::from_chars(value.data(), value.data() + value.size(), number).ptr == value.data() + value.size();
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 2; i < argc; i++) {
+        const std::string_view option(argv[i]);
+        if (option == "--arena"sv) {
+            options.use_arena = true;
+        }
+        else if (option == "--input"sv && i + 1 < argc) {
+            options.input_file = argv[++i];
+        }
+        else if (option == "--threads"sv && i + 1 < argc) {
+            size_t thread_count = 0;
+            if (!ParseNumber(argv[++i], thread_count)) {
+                return false;
+            }
+            options.thread_count = thread_count != 0 ? thread_count : std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        else if (option == "--cache-mb"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], options.cache_mb)) {
+                return false;
+            }
+        }
+        else if (option == "--cache-stats"sv) {
+            options.print_cache_stats = true;
+        }
+        else if (option == "--ndjson"sv) {
+            options.ndjson = true;
+        }
+        else if (option == "--compact"sv) {
+            options.output_format.compact = true;
+        }
+        else if (option == "--round-trip-doubles"sv) {
+            options.output_format.round_trip_doubles = true;
+        }
+        else if (option == "--flat-base"sv) {
+            options.flat_base = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    Options options;
+    if (argc < 2 || !ParseOptions(argc, argv, options)) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
+    // the standard streams get buffers of their own, so the line mode can see whether input is waiting
+    std::ios::sync_with_stdio(false);
+
+    // the arena never frees memory before it is destroyed, so building the base costs
+    // a few large allocations and tearing it down costs no per-object deallocation
+    CountingResource arena_upstream;
+    std::pmr::monotonic_buffer_resource arena(&arena_upstream);
+    std::pmr::memory_resource* resource = options.use_arena ? &arena : std::pmr::get_default_resource();
+
+    // the parser reads the mapped text in place, without copying it into a stream buffer
+    std::optional<MappedFile> input;
+    if (options.input_file) {
+        input.emplace(*options.input_file);
+    }
+
     if (mode == "make_base"sv) {
 
-        TransportCatalogue catalogue;
+        TransportCatalogue catalogue(resource);
         JsonReader json_reader(catalogue, cin, cout);
+        if (input) {
+            json_reader.SetInput(input->GetData());
+        }
+        json_reader.SetThreadCount(options.thread_count);
         json_reader.ReadMakeBaseInput();
-        serialization::SerializeTransportCatalogue(catalogue, json_reader.GetSerializationFileName(), json_reader.GetRenderSettings(), json_reader.GetRouterSettings());
+        if (options.flat_base) {
+            serialization::SerializeFlatBase(catalogue, json_reader.GetSerializationFileName(), json_reader.GetRenderSettings(), json_reader.GetRouterSettings());
+        }
+        else {
+            serialization::SerializeTransportCatalogue(catalogue, json_reader.GetSerializationFileName(), json_reader.GetRenderSettings(), json_reader.GetRouterSettings());
+        }
     }
     else if (mode == "process_requests"sv) {
 
-        TransportCatalogue catalogue;
+        TransportCatalogue catalogue(resource);
         JsonReader json_reader(catalogue, cin, cout);
-        json_reader.ReadProcessRequest();
-        Rendering::RenderSettings render_settings;
-        auto light_router = serialization::DeserializeTransportCatalogue(json_reader.GetSerializationFileName(), catalogue, render_settings);
-        json_reader.SetRenderSettings(render_settings);
-        json_reader.ProcessStatRequests(light_router);
+        if (input) {
+            json_reader.SetInput(input->GetData());
+        }
+        json_reader.SetThreadCount(options.thread_count);
+        json_reader.SetOutputFormat(options.output_format);
+        json_reader.SetResponseCacheCapacity(options.cache_mb << 20);
+        // only the loading thread touches the catalogue and the resource until the base is loaded;
+        // later only the router section allocates from the resource, once and in one thread
+        const auto load_base = [&catalogue, resource, &options](const std::string& filename) {
+            return std::make_unique<serialization::BaseFile>(filename, catalogue, resource, options.thread_count);
+        };
+        if (options.ndjson) {
+            json_reader.ProcessRequestLines(load_base);
+        }
+        else {
+            json_reader.ProcessRequests(load_base);
+        }
+        if (const auto cache = json_reader.GetResponseCache(); cache && options.print_cache_stats) {
+            const auto stats = cache->GetStats();
+            const size_t requests = stats.hits + stats.misses;
+            cerr << "Response cache: "sv << stats.hits << " hits, "sv << stats.misses << " misses ("sv
+                << (requests != 0 ? 100. * stats.hits / requests : 0.) << "% hit rate), "sv
+                << stats.evictions << " evictions, "sv << stats.entries << " entries, "sv << stats.bytes << " bytes\n"sv;
+        }
     }
     else {
         PrintUsage();
         return 1;
     }
+
+    if (options.use_arena) {
+        cerr << "Arena memory: "sv << arena_upstream.GetPeakBytes() << " bytes\n"sv;
+    }
 }
\ No newline at end of file
@@ -33,14 +33,7 @@ void MapRenderer::Render()
 
 void MapRenderer::AddRoutes()
 {
-	std::vector<const Bus*> routes;
-	for (const auto& bus : catalogue_.GetBuses()) {
-		routes.push_back(&bus);
-	}
-	std::sort(routes.begin(), routes.end(), [](const Bus* lhv, const Bus* rhv) {
-		return lhv->name < rhv->name;
-		});
-	for (const auto bus : routes) {
+	for (const auto bus : catalogue_.GetBusesByName()) {
 		//   AddRouteTitle, .. AddRoute()   
 		AddRouteTitle(*bus);
 		AddRoute(*bus);
@@ -110,7 +103,7 @@ void MapRenderer::AddRouteTitle(const Bus& route)
 	background.SetFontSize(settings_.bus_label_font_size);
 	background.SetFontFamily("Verdana");
 	background.SetFontWeight("bold");
-	background.SetData(route.name);
+	background.SetData(std::string(route.name));
 	background.SetFillColor(settings_.underlayer_color);
 	background.SetStrokeColor(settings_.underlayer_color);
 	background.SetStrokeWidth(settings_.underlayer_width);
@@ -123,7 +116,7 @@ void MapRenderer::AddRouteTitle(const Bus& route)
 	title.SetFontSize(settings_.bus_label_font_size);
 	title.SetFontFamily("Verdana");
 	title.SetFontWeight("bold");
-	title.SetData(route.name);
+	title.SetData(std::string(route.name));
 	//      AddRoute(),         
 	title.SetFillColor(settings_.color_palette[routes_count_ % settings_.color_palette.size()]);
 
@@ -163,7 +156,7 @@ void MapRenderer::AddStopTitle(const Stop& stop)
 	background.SetOffset(settings_.stop_label_offset);
 	background.SetFontSize(settings_.stop_label_font_size);
 	background.SetFontFamily("Verdana");
-	background.SetData(stop.name);
+	background.SetData(std::string(stop.name));
 	background.SetFillColor(settings_.underlayer_color);
 	background.SetStrokeColor(settings_.underlayer_color);
 	background.SetStrokeWidth(settings_.underlayer_width);
@@ -175,7 +168,7 @@ void MapRenderer::AddStopTitle(const Stop& stop)
 	title.SetOffset(settings_.stop_label_offset);
 	title.SetFontSize(settings_.stop_label_font_size);
 	title.SetFontFamily("Verdana");
-	title.SetData(stop.name);
+	title.SetData(std::string(stop.name));
 	title.SetFillColor("black");
 
 	stop_titles_.push_back(std::move(background));
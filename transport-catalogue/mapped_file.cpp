@@ -0,0 +1,120 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Transport;
+using namespace std;
+
+#ifdef _WIN32
+
+Transport::MappedFile::MappedFile(const std::string& path, Access access)
+{
+	file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		access == Access::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE)
+	{
+		throw system_error(static_cast<int>(GetLastError()), system_category(), "Can't open "s + path);
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_, &size))
+	{
+		const auto error = static_cast<int>(GetLastError());
+		CloseHandle(file_);
+		throw system_error(error, system_category(), "Can't get the size of "s + path);
+	}
+	size_ = static_cast<size_t>(size.QuadPart);
+	if (size_ == 0)
+	{
+		// an empty file can't be mapped
+		return;
+	}
+	mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		const auto error = static_cast<int>(GetLastError());
+		if (mapping_)
+		{
+			CloseHandle(mapping_);
+		}
+		CloseHandle(file_);
+		throw system_error(error, system_category(), "Can't map "s + path);
+	}
+	data_ = static_cast<const char*>(view);
+}
+
+Transport::MappedFile::~MappedFile()
+{
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+	}
+	CloseHandle(file_);
+}
+
+#else
+
+Transport::MappedFile::MappedFile(const std::string& path, Access access)
+{
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw system_error(errno, generic_category(), "Can't open "s + path);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		const int error = errno;
+		close(fd);
+		throw system_error(error, generic_category(), "Can't get the size of "s + path);
+	}
+	size_ = static_cast<size_t>(info.st_size);
+	if (size_ == 0)
+	{
+		// an empty file can't be mapped
+		close(fd);
+		return;
+	}
+	void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	const int error = errno;
+	// the mapping keeps the file open by itself
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		throw system_error(error, generic_category(), "Can't map "s + path);
+	}
+	// a file read from start to end is worth reading ahead more, a file read at random less
+	madvise(data, size_, access == Access::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+	data_ = static_cast<const char*>(data);
+}
+
+Transport::MappedFile::~MappedFile()
+{
+	if (data_)
+	{
+		munmap(const_cast<char*>(data_), size_);
+	}
+}
+
+#endif
+
+std::string_view Transport::MappedFile::GetData() const
+{
+	return { data_, size_ };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Transport {
+
+	// Read-only mapping of a whole file into memory. Nothing is read up front:
+	// the system loads pages on first access, so the file may be larger than the free memory.
+	class MappedFile
+	{
+	public:
+		// how the file is going to be read, so the system reads ahead as much as is useful
+		enum class Access
+		{
+			SEQUENTIAL,
+			RANDOM
+		};
+
+		// throws std::system_error if the file can't be opened or mapped
+		explicit MappedFile(const std::string& path, Access access = Access::SEQUENTIAL);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		// the contents of the file, valid for the lifetime of the mapping
+		std::string_view GetData() const;
+
+	private:
+		const char* data_ = nullptr;
+		size_t size_ = 0;
+#ifdef _WIN32
+		void* file_ = nullptr;
+		void* mapping_ = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,158 @@
+#include "name_search_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	bool StartsWith(std::string_view str, std::string_view prefix)
+	{
+		return str.substr(0, prefix.size()) == prefix;
+	}
+}
+
+Transport::NameSearchIndex::NameSearchIndex(const std::vector<std::string_view>& names)
+	: order_(names.size())
+{
+	iota(order_.begin(), order_.end(), 0);
+	sort(order_.begin(), order_.end(), [&names](uint32_t lhv, uint32_t rhv) {
+		return names[lhv] < names[rhv];
+		});
+
+	sorted_names_.reserve(names.size());
+	for (const auto id : order_) {
+		sorted_names_.push_back(names[id]);
+	}
+}
+
+Transport::NameSearchIndex::NameSearchIndex(const std::vector<std::string_view>& names, std::vector<uint32_t> order)
+	: order_(std::move(order))
+{
+	sorted_names_.reserve(order_.size());
+	for (const auto id : order_) {
+		sorted_names_.push_back(names.at(id));
+	}
+}
+
+std::vector<size_t> Transport::NameSearchIndex::FindByPrefix(std::string_view prefix, size_t count) const
+{
+	vector<size_t> result;
+	const size_t begin = lower_bound(sorted_names_.begin(), sorted_names_.end(), prefix) - sorted_names_.begin();
+	for (size_t i = begin; i < sorted_names_.size() && result.size() < count && StartsWith(sorted_names_[i], prefix); i++)
+	{
+		result.push_back(order_[i]);
+	}
+	return result;
+}
+
+std::vector<size_t> Transport::NameSearchIndex::FindFuzzy(std::string_view query, size_t max_errors, size_t count) const
+{
+	// deleting the whole query matches the empty prefix of any name, so more errors change nothing
+	max_errors = min(max_errors, query.size());
+	if (max_errors == 0)
+	{
+		return FindByPrefix(query, count);
+	}
+
+	// matches[e] - positions of the names with e errors, the first count of them in name order
+	vector<vector<size_t>> matches(max_errors + 1);
+	const auto add_match = [&](size_t errors, size_t position) {
+		if (matches[errors].size() < count)
+		{
+			matches[errors].push_back(position);
+		}
+	};
+
+	// rows[depth] - edit distances between the prefixes of query and the first depth bytes of the name,
+	// best[depth] - the fewest errors of a name prefix not longer than depth
+	const size_t width = query.size() + 1;
+	vector<size_t> rows(width);
+	iota(rows.begin(), rows.end(), 0);
+	vector<size_t> best{ query.size() };
+
+	// rows are valid for the first valid_depth bytes of previous
+	std::string_view previous;
+	size_t valid_depth = 0;
+	size_t position = 0;
+	while (position < sorted_names_.size() && matches[0].size() < count)
+	{
+		const std::string_view name = sorted_names_[position];
+		size_t depth = mismatch(name.begin(), name.begin() + min(name.size(), valid_depth), previous.begin()).first - name.begin();
+
+		bool hopeless = false;
+		while (depth < name.size() && !hopeless)
+		{
+			if (rows.size() < (depth + 2) * width)
+			{
+				rows.resize((depth + 2) * width);
+				best.resize(depth + 2);
+			}
+			const size_t* row = &rows[depth * width];
+			size_t* next = &rows[(depth + 1) * width];
+
+			next[0] = depth + 1;
+			size_t row_min = next[0];
+			for (size_t j = 1; j < width; j++)
+			{
+				const size_t substitution = row[j - 1] + (query[j - 1] == name[depth] ? 0 : 1);
+				next[j] = min({ substitution, row[j] + 1, next[j - 1] + 1 });
+				row_min = min(row_min, next[j]);
+			}
+			best[depth + 1] = min(best[depth], next[width - 1]);
+			++depth;
+
+			// the distances never decrease down the rows, so longer prefixes can't get within max_errors
+			hopeless = row_min > max_errors;
+		}
+		previous = name;
+		valid_depth = depth;
+
+		const size_t errors = best[depth];
+		if (!hopeless)
+		{
+			if (errors <= max_errors)
+			{
+				add_match(errors, position);
+			}
+			++position;
+			continue;
+		}
+
+		// every name sharing the prefix ends the same way
+		const size_t end = SkipPrefix(position, name.substr(0, depth));
+		if (errors <= max_errors)
+		{
+			for (size_t i = position; i < end && matches[errors].size() < count; i++)
+			{
+				add_match(errors, i);
+			}
+		}
+		position = end;
+	}
+
+	vector<size_t> result;
+	for (const auto& positions : matches) {
+		for (const auto match : positions) {
+			if (result.size() == count)
+			{
+				return result;
+			}
+			result.push_back(order_[match]);
+		}
+	}
+	return result;
+}
+
+const std::vector<uint32_t>& Transport::NameSearchIndex::GetOrder() const
+{
+	return order_;
+}
+
+size_t Transport::NameSearchIndex::SkipPrefix(size_t begin, std::string_view prefix) const
+{
+	return partition_point(sorted_names_.begin() + begin, sorted_names_.end(), [prefix](std::string_view name) {
+		return StartsWith(name, prefix);
+		}) - sorted_names_.begin();
+}
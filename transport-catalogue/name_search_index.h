@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Transport {
+
+	// Names sorted lexicographically, for autocomplete. Names with a common prefix are adjacent,
+	// so a prefix lookup is a binary search, and the fuzzy search walks the sorted list like a trie,
+	// reusing the edit distance rows of the shared prefix and skipping hopeless prefixes entirely.
+	// Names are compared and edited bytewise.
+	class NameSearchIndex
+	{
+	public:
+		NameSearchIndex() = default;
+
+		// builds the index, names[i] gets id i; the names must outlive the index
+		explicit NameSearchIndex(const std::vector<std::string_view>& names);
+
+		// restores the index from the order returned by GetOrder()
+		NameSearchIndex(const std::vector<std::string_view>& names, std::vector<uint32_t> order);
+
+		// ids of at most count names starting with prefix, in name order
+		std::vector<size_t> FindByPrefix(std::string_view prefix, size_t count) const;
+
+		// ids of at most count names with a prefix within max_errors edits (insertion, deletion,
+		// substitution) of query; fewest errors first, then in name order
+		std::vector<size_t> FindFuzzy(std::string_view query, size_t max_errors, size_t count) const;
+
+		// reading for serialization: ids in name order
+		const std::vector<uint32_t>& GetOrder() const;
+
+	private:
+		// position of the first name after begin not starting with prefix
+		size_t SkipPrefix(size_t begin, std::string_view prefix) const;
+
+	private:
+		std::vector<uint32_t> order_;
+		// names in the order of order_
+		std::vector<std::string_view> sorted_names_;
+	};
+}
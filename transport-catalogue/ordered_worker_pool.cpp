@@ -0,0 +1,108 @@
+#include "ordered_worker_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Transport;
+using namespace std;
+
+Transport::OrderedWorkerPool::OrderedWorkerPool(size_t thread_count, Consumer consumer, size_t window)
+	: consumer_(std::move(consumer)), slots_(std::max<size_t>(window, 1))
+{
+	threads_.reserve(thread_count);
+	for (size_t i = 0; i < thread_count; i++)
+	{
+		threads_.emplace_back([this] { Work(); });
+	}
+}
+
+Transport::OrderedWorkerPool::~OrderedWorkerPool()
+{
+	{
+		lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	task_added_.notify_all();
+	for (auto& thread : threads_) {
+		thread.join();
+	}
+}
+
+void Transport::OrderedWorkerPool::Submit(Task task)
+{
+	unique_lock lock(mutex_);
+	Consume(lock, false);
+	while (submitted_ - consumed_ == slots_.size())
+	{
+		Consume(lock, true);
+	}
+
+	Slot& slot = slots_[submitted_ % slots_.size()];
+	slot.task = std::move(task);
+	slot.output.clear();
+	slot.error = nullptr;
+	slot.done = false;
+	++submitted_;
+	lock.unlock();
+	task_added_.notify_one();
+}
+
+void Transport::OrderedWorkerPool::Finish()
+{
+	unique_lock lock(mutex_);
+	while (consumed_ < submitted_)
+	{
+		Consume(lock, true);
+	}
+}
+
+void Transport::OrderedWorkerPool::Work()
+{
+	unique_lock lock(mutex_);
+	while (true)
+	{
+		task_added_.wait(lock, [this] { return stopping_ || started_ < submitted_; });
+		if (started_ == submitted_)
+		{
+			return;
+		}
+		// slots from consumed_ to submitted_ are not reused, so the slot is used without the lock
+		Slot& slot = slots_[started_++ % slots_.size()];
+		lock.unlock();
+		try
+		{
+			slot.task(slot.output);
+		}
+		catch (...)
+		{
+			slot.error = current_exception();
+		}
+		slot.task = nullptr;
+		lock.lock();
+		slot.done = true;
+		task_done_.notify_all();
+	}
+}
+
+void Transport::OrderedWorkerPool::Consume(std::unique_lock<std::mutex>& lock, bool wait)
+{
+	if (wait)
+	{
+		task_done_.wait(lock, [this] { return slots_[consumed_ % slots_.size()].done; });
+	}
+	while (consumed_ < submitted_ && slots_[consumed_ % slots_.size()].done)
+	{
+		// workers don't touch a done slot, so it is read without the lock
+		Slot& slot = slots_[consumed_ % slots_.size()];
+		lock.unlock();
+		if (slot.error)
+		{
+			lock.lock();
+			++consumed_;
+			rethrow_exception(std::exchange(slot.error, nullptr));
+		}
+		consumer_(slot.output);
+		lock.lock();
+		++consumed_;
+	}
+}
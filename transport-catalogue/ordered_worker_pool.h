@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Transport {
+
+	// Runs tasks on worker threads. Each task writes its text into a buffer of its own, and the texts
+	// are passed to the consumer in the order the tasks were submitted, on the submitting thread.
+	// At most window tasks are in flight, so a slow task holds back a bounded amount of output.
+	class OrderedWorkerPool
+	{
+	public:
+		using Task = std::function<void(std::string& output)>;
+		using Consumer = std::function<void(const std::string& output)>;
+
+		static constexpr size_t DEFAULT_WINDOW = 1024;
+
+		OrderedWorkerPool(size_t thread_count, Consumer consumer, size_t window = DEFAULT_WINDOW);
+		OrderedWorkerPool(const OrderedWorkerPool&) = delete;
+		OrderedWorkerPool& operator=(const OrderedWorkerPool&) = delete;
+		~OrderedWorkerPool();
+
+		// passes the texts completed so far to the consumer, waits while the window is full;
+		// an exception thrown by a task is rethrown here or by Finish() in the order of the tasks
+		void Submit(Task task);
+
+		// waits for all the submitted tasks and passes the rest of the texts to the consumer
+		void Finish();
+
+	private:
+		struct Slot
+		{
+			Task task;
+			std::string output;
+			std::exception_ptr error;
+			bool done = false;
+		};
+
+		void Work();
+
+		// passes the completed texts at the head to the consumer, if wait is set waits for the head first
+		void Consume(std::unique_lock<std::mutex>& lock, bool wait);
+
+	private:
+		Consumer consumer_;
+		// task i lives in slots_[i % slots_.size()] from its submission until its text is consumed
+		std::vector<Slot> slots_;
+		size_t submitted_ = 0;
+		size_t started_ = 0;
+		size_t consumed_ = 0;
+		bool stopping_ = false;
+
+		std::mutex mutex_;
+		std::condition_variable task_added_;
+		std::condition_variable task_done_;
+		std::vector<std::thread> threads_;
+	};
+}
@@ -0,0 +1,145 @@
+#include "ordered_worker_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	int failures = 0;
+
+	void Check(bool condition, std::string_view what)
+	{
+		if (!condition)
+		{
+			cerr << "FAILED: "sv << what << '\n';
+			++failures;
+		}
+	}
+
+	const size_t WINDOWS[] = { 1, 2, 3, 16, OrderedWorkerPool::DEFAULT_WINDOW };
+	const size_t THREAD_COUNTS[] = { 1, 2, 5 };
+	const int TASK_COUNT = 2000;
+
+	// some tasks are slow, so later ones complete first
+	void Work(int i, string& output)
+	{
+		if (i % 7 == 0)
+		{
+			this_thread::sleep_for(chrono::microseconds(50));
+		}
+		output = to_string(i);
+	}
+
+	void TestOrder()
+	{
+		for (const size_t window : WINDOWS) {
+			for (const size_t thread_count : THREAD_COUNTS) {
+				vector<int> consumed;
+				bool on_submitting_thread = true;
+				const auto submitting_thread = this_thread::get_id();
+				{
+					OrderedWorkerPool pool(thread_count, [&](const string& output) {
+						consumed.push_back(stoi(output));
+						on_submitting_thread = on_submitting_thread && this_thread::get_id() == submitting_thread;
+						}, window);
+					for (int i = 0; i < TASK_COUNT; i++)
+					{
+						pool.Submit([i](string& output) { Work(i, output); });
+					}
+					pool.Finish();
+				}
+
+				bool in_order = consumed.size() == TASK_COUNT;
+				for (size_t i = 0; in_order && i < consumed.size(); i++)
+				{
+					in_order = consumed[i] == static_cast<int>(i);
+				}
+				Check(in_order, "the texts are consumed in the order of the tasks"sv);
+				Check(on_submitting_thread, "the texts are consumed on the submitting thread"sv);
+			}
+		}
+	}
+
+	// the exception of a task is rethrown after the texts of the tasks before it, and none after
+	void TestException()
+	{
+		const int failing_task = 777;
+		for (const size_t window : WINDOWS) {
+			for (const size_t thread_count : THREAD_COUNTS) {
+				vector<int> consumed;
+				string error;
+				OrderedWorkerPool pool(thread_count, [&consumed](const string& output) {
+					consumed.push_back(stoi(output));
+					}, window);
+				try
+				{
+					for (int i = 0; i < TASK_COUNT; i++)
+					{
+						pool.Submit([i](string& output) {
+							if (i == failing_task)
+							{
+								throw runtime_error("task "s + to_string(i));
+							}
+							Work(i, output);
+							});
+					}
+					pool.Finish();
+				}
+				catch (const runtime_error& e)
+				{
+					error = e.what();
+				}
+
+				bool is_prefix = consumed.size() == failing_task;
+				for (size_t i = 0; is_prefix && i < consumed.size(); i++)
+				{
+					is_prefix = consumed[i] == static_cast<int>(i);
+				}
+				Check(error == "task 777"sv, "the exception of the task is rethrown"sv);
+				Check(is_prefix, "the exception is rethrown right after the texts of the tasks before it"sv);
+
+				// the pool goes on with the tasks submitted after the failed one
+				pool.Finish();
+				Check(consumed.empty() || consumed.back() != failing_task, "the failed task has no text"sv);
+			}
+		}
+	}
+
+	// the pool is destroyed with tasks in flight, which complete and are dropped
+	void TestDestroyUnfinished()
+	{
+		atomic<int> completed = 0;
+		{
+			OrderedWorkerPool pool(3, [](const string&) {}, 16);
+			for (int i = 0; i < 16; i++)
+			{
+				pool.Submit([i, &completed](string& output) {
+					Work(i, output);
+					++completed;
+					});
+			}
+		}
+		Check(completed == 16, "the tasks in flight complete before the pool is destroyed"sv);
+	}
+}
+
+int main()
+{
+	TestOrder();
+	TestException();
+	TestDestroyUnfinished();
+	if (failures == 0)
+	{
+		cerr << "ordered_worker_pool_test OK"sv << '\n';
+	}
+	return failures == 0 ? 0 : 1;
+}
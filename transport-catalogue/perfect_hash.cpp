@@ -0,0 +1,187 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	// average number of names in a bucket
+	const size_t BUCKET_LOAD = 4;
+
+	uint64_t Mix(uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+}
+
+Transport::PerfectHash::PerfectHash(const std::vector<std::string_view>& names)
+{
+	// a repeated name keeps the id of its last occurrence, as the name maps did
+	vector<uint32_t> name_ids(names.size());
+	iota(name_ids.begin(), name_ids.end(), 0);
+	stable_sort(name_ids.begin(), name_ids.end(), [&names](uint32_t lhv, uint32_t rhv) {
+		return names[lhv] < names[rhv];
+		});
+	vector<uint32_t> unique_ids;
+	unique_ids.reserve(name_ids.size());
+	for (size_t i = 0; i < name_ids.size(); i++)
+	{
+		if (i + 1 == name_ids.size() || names[name_ids[i]] != names[name_ids[i + 1]])
+		{
+			unique_ids.push_back(name_ids[i]);
+		}
+	}
+
+	const size_t size = unique_ids.size();
+	if (size == 0)
+	{
+		return;
+	}
+
+	// distinct names with the same hash can't be told apart, so the names are hashed with another salt
+	vector<uint64_t> hashes(size);
+	vector<uint64_t> sorted_hashes;
+	for (;; ++salt_)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hashes[i] = Hash(names[unique_ids[i]], salt_);
+		}
+		sorted_hashes = hashes;
+		sort(sorted_hashes.begin(), sorted_hashes.end());
+		if (adjacent_find(sorted_hashes.begin(), sorted_hashes.end()) == sorted_hashes.end())
+		{
+			break;
+		}
+	}
+
+	seeds_.assign((size + BUCKET_LOAD - 1) / BUCKET_LOAD, 0);
+	vector<vector<uint32_t>> buckets(seeds_.size());
+	for (size_t i = 0; i < size; i++)
+	{
+		buckets[GetBucket(hashes[i])].push_back(static_cast<uint32_t>(i));
+	}
+
+	// the largest buckets are the hardest to place, so they go first while most slots are free
+	vector<size_t> order(buckets.size());
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&buckets](size_t lhv, size_t rhv) {
+		return buckets[lhv].size() > buckets[rhv].size();
+		});
+
+	ids_.assign(size, 0);
+	fingerprints_.assign(size, 0);
+	vector<bool> taken(size, false);
+	vector<size_t> bucket_slots;
+	for (const size_t bucket : order) {
+		const auto& keys = buckets[bucket];
+		if (keys.empty())
+		{
+			break;
+		}
+
+		for (uint32_t seed = 0;; ++seed)
+		{
+			bucket_slots.clear();
+			for (const auto key : keys) {
+				const size_t slot = GetSlot(hashes[key], seed);
+				if (taken[slot] || find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end())
+				{
+					break;
+				}
+				bucket_slots.push_back(slot);
+			}
+			if (bucket_slots.size() == keys.size())
+			{
+				seeds_[bucket] = seed;
+				break;
+			}
+		}
+
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			taken[bucket_slots[i]] = true;
+			ids_[bucket_slots[i]] = unique_ids[keys[i]];
+			fingerprints_[bucket_slots[i]] = GetFingerprint(hashes[keys[i]]);
+		}
+	}
+}
+
+Transport::PerfectHash::PerfectHash(std::vector<uint32_t> seeds, std::vector<uint32_t> ids, std::vector<uint32_t> fingerprints,
+	uint32_t salt)
+	: seeds_(std::move(seeds)), ids_(std::move(ids)), fingerprints_(std::move(fingerprints)), salt_(salt)
+{
+}
+
+std::optional<size_t> Transport::PerfectHash::Find(std::string_view name) const
+{
+	if (ids_.empty())
+	{
+		return std::nullopt;
+	}
+	const uint64_t hash = Hash(name, salt_);
+	const size_t slot = GetSlot(hash, seeds_[GetBucket(hash)]);
+	if (fingerprints_[slot] != GetFingerprint(hash))
+	{
+		return std::nullopt;
+	}
+	return ids_[slot];
+}
+
+size_t Transport::PerfectHash::GetSize() const
+{
+	return ids_.size();
+}
+
+const std::vector<uint32_t>& Transport::PerfectHash::GetSeeds() const
+{
+	return seeds_;
+}
+
+const std::vector<uint32_t>& Transport::PerfectHash::GetIds() const
+{
+	return ids_;
+}
+
+const std::vector<uint32_t>& Transport::PerfectHash::GetFingerprints() const
+{
+	return fingerprints_;
+}
+
+uint32_t Transport::PerfectHash::GetSalt() const
+{
+	return salt_;
+}
+
+uint64_t Transport::PerfectHash::Hash(std::string_view name, uint32_t salt)
+{
+	// FNV-1a from a basis changed by the salt; Mix(0) is 0, so salt 0 keeps the hashes of older bases
+	uint64_t hash = 14695981039346656037ULL ^ Mix(salt);
+	for (const char c : name) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return Mix(hash);
+}
+
+size_t Transport::PerfectHash::GetBucket(uint64_t hash) const
+{
+	return static_cast<size_t>((hash >> 32) % seeds_.size());
+}
+
+size_t Transport::PerfectHash::GetSlot(uint64_t hash, uint32_t seed) const
+{
+	return static_cast<size_t>(Mix(hash + seed * 0x9e3779b97f4a7c15ULL) % ids_.size());
+}
+
+uint32_t Transport::PerfectHash::GetFingerprint(uint64_t hash)
+{
+	return static_cast<uint32_t>(hash);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace Transport {
+
+	// Minimal perfect hash over a fixed set of names (hash and displace).
+	// Every name of the set maps to its own slot, so a lookup is a single probe.
+	// A name outside the set also lands in some slot; the stored fingerprint rejects
+	// most of those, and the caller must compare the name to reject the rest.
+	class PerfectHash
+	{
+	public:
+		PerfectHash() = default;
+
+		// builds the hash for names, names[i] gets id i; a repeated name gets the id of its last occurrence
+		explicit PerfectHash(const std::vector<std::string_view>& names);
+
+		// restores the hash from the data returned by the getters below
+		PerfectHash(std::vector<uint32_t> seeds, std::vector<uint32_t> ids, std::vector<uint32_t> fingerprints,
+			uint32_t salt = 0);
+
+		// id of the name if it may belong to the set
+		std::optional<size_t> Find(std::string_view name) const;
+
+		size_t GetSize() const;
+
+		// reading for serialization
+		const std::vector<uint32_t>& GetSeeds() const;
+		const std::vector<uint32_t>& GetIds() const;
+		const std::vector<uint32_t>& GetFingerprints() const;
+		uint32_t GetSalt() const;
+
+	private:
+		// stable across platforms since the hash is stored in the base
+		static uint64_t Hash(std::string_view name, uint32_t salt);
+		size_t GetBucket(uint64_t hash) const;
+		size_t GetSlot(uint64_t hash, uint32_t seed) const;
+		static uint32_t GetFingerprint(uint64_t hash);
+
+	private:
+		// displacement seed for each bucket
+		std::vector<uint32_t> seeds_;
+		// name id for each slot
+		std::vector<uint32_t> ids_;
+		// name fingerprint for each slot
+		std::vector<uint32_t> fingerprints_;
+		// changes the hash of every name, picked so that no two names of the set hash alike
+		uint32_t salt_ = 0;
+	};
+}
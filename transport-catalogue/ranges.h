@@ -12,6 +12,7 @@ namespace ranges {
     public:
         using ValueType = typename std::iterator_traits<It>::value_type;
 
+        Range() = default;
         Range(It begin, It end)
             : begin_(begin)
             , end_(end) {
@@ -22,10 +23,16 @@ namespace ranges {
         It end() const {
             return end_;
         }
+        size_t size() const {
+            return static_cast<size_t>(std::distance(begin_, end_));
+        }
+        bool empty() const {
+            return begin_ == end_;
+        }
 
     private:
-        It begin_;
-        It end_;
+        It begin_{};
+        It end_{};
     };
 
     template <typename C>
@@ -1,4 +1,7 @@
 #include "request_handler.h"
+#include "json_writer.h"
+
+#include <sstream>
 
 using namespace Transport;
 using namespace Rendering;
@@ -6,8 +9,7 @@ using namespace Rendering;
 SphereProjector MakeProjector(const TransportCatalogue& catalogue, const RenderSettings& settings) {
 	std::vector<Geo::Coordinates> all_coords;
 	for (const Stop* stop : catalogue.GetStops()) {
-		const auto buses_ptr = catalogue.GetStopToBuses(stop);
-		if (!buses_ptr.empty())
+		if (!catalogue.GetStopToBuses(stop).empty())
 		{
 			all_coords.push_back(stop->coords);
 		}
@@ -22,3 +24,15 @@ void Transport::Rendering::RenderCatalogue(const TransportCatalogue& catalogue,
 
 	renderer.Render();
 }
+
+Transport::Rendering::RenderedMap Transport::Rendering::RenderMap(const TransportCatalogue& catalogue, const RenderSettings& settings)
+{
+	std::ostringstream out;
+	RenderCatalogue(catalogue, settings, out);
+
+	RenderedMap map;
+	map.svg = out.str();
+	map.json_escaped_svg.reserve(map.svg.size() + map.svg.size() / 8);
+	json::AppendEscaped(map.svg, map.json_escaped_svg);
+	return map;
+}
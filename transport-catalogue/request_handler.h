@@ -2,6 +2,27 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 
+#include <string>
+#include <string_view>
+
 namespace Transport::Rendering {
 	void RenderCatalogue(const Transport::TransportCatalogue& catalogue, const Transport::Rendering::RenderSettings& settings, std::ostream& out = std::cout);
+
+	// the map depends on the catalogue and the render settings only, so make_base renders it
+	// into the base and a Map request copies it from there
+	struct RenderedMap
+	{
+		std::string svg;
+		// svg escaped as in a JSON string, without the quotes
+		std::string json_escaped_svg;
+	};
+
+	RenderedMap RenderMap(const Transport::TransportCatalogue& catalogue, const Transport::Rendering::RenderSettings& settings);
+
+	// the rendered map in a loaded base, empty if the base has none
+	struct RenderedMapView
+	{
+		std::string_view svg;
+		std::string_view json_escaped_svg;
+	};
 }
@@ -0,0 +1,103 @@
+#include "response_cache.h"
+
+#include <charconv>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	// the key of request_id as the writer prints it, followed by a space unless the output is compact
+	constexpr string_view REQUEST_ID_KEY = "\"request_id\":"sv;
+}
+
+Transport::ResponseCache::ResponseCache(size_t capacity)
+	: capacity_(capacity)
+{
+}
+
+bool Transport::ResponseCache::Find(std::string_view key, int request_id, std::string& response)
+{
+	shared_ptr<const Response> found;
+	{
+		lock_guard lock(mutex_);
+		const auto it = index_.find(key);
+		if (it == index_.end())
+		{
+			++stats_.misses;
+			return false;
+		}
+		++stats_.hits;
+		entries_.splice(entries_.begin(), entries_, it->second);
+		found = it->second->response;
+	}
+
+	// the entry may be dropped meanwhile, the response lives while it is copied
+	char id[16];
+	const auto id_end = to_chars(begin(id), end(id), request_id).ptr;
+	const string_view text = found->text;
+	response.append(text.substr(0, found->id_pos))
+		.append(id, id_end)
+		.append(text.substr(found->id_pos));
+	return true;
+}
+
+void Transport::ResponseCache::Store(std::string key, std::string_view response, int request_id)
+{
+	// "request_id" is written only as a key, quotes inside of strings are escaped
+	const auto key_pos = response.find(REQUEST_ID_KEY);
+	if (key_pos == string_view::npos)
+	{
+		return;
+	}
+	size_t id_pos = key_pos + REQUEST_ID_KEY.size();
+	if (id_pos < response.size() && response[id_pos] == ' ')
+	{
+		++id_pos;
+	}
+	int written_id = 0;
+	const auto [id_end, error] = from_chars(response.data() + id_pos, response.data() + response.size(), written_id);
+	if (error != errc{} || written_id != request_id)
+	{
+		return;
+	}
+
+	auto stored = make_shared<Response>();
+	stored->text.reserve(response.size());
+	stored->text.append(response.substr(0, id_pos)).append(id_end, response.data() + response.size());
+	stored->id_pos = id_pos;
+	Entry entry{ std::move(key), std::move(stored) };
+	const size_t size = GetSize(entry);
+	if (size > capacity_)
+	{
+		return;
+	}
+
+	lock_guard lock(mutex_);
+	if (index_.count(entry.key) != 0)
+	{
+		// another thread has answered the same request
+		return;
+	}
+	while (stats_.bytes + size > capacity_)
+	{
+		stats_.bytes -= GetSize(entries_.back());
+		index_.erase(entries_.back().key);
+		entries_.pop_back();
+		++stats_.evictions;
+	}
+	entries_.push_front(std::move(entry));
+	index_.emplace(entries_.front().key, entries_.begin());
+	stats_.bytes += size;
+	stats_.entries = entries_.size();
+}
+
+ResponseCache::Stats Transport::ResponseCache::GetStats() const
+{
+	lock_guard lock(mutex_);
+	return stats_;
+}
+
+size_t Transport::ResponseCache::GetSize(const Entry& entry)
+{
+	return entry.key.size() + entry.response->text.size();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Transport {
+
+	// Serialized responses to stat requests by the content of the request without its id.
+	// A response is stored without its request_id, which is put back on every hit.
+	// The least recently used responses are dropped when the total size exceeds the capacity.
+	// Safe to use from several threads.
+	class ResponseCache
+	{
+	public:
+		static constexpr size_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+		struct Stats
+		{
+			size_t hits = 0;
+			size_t misses = 0;
+			size_t evictions = 0;
+			size_t entries = 0;
+			// keys and responses
+			size_t bytes = 0;
+		};
+
+		// capacity in bytes
+		explicit ResponseCache(size_t capacity = DEFAULT_CAPACITY);
+
+		// appends the response for key with request_id, returns false if there is none
+		bool Find(std::string_view key, int request_id, std::string& response);
+
+		// response must contain "request_id": request_id, otherwise it is not stored
+		void Store(std::string key, std::string_view response, int request_id);
+
+		Stats GetStats() const;
+
+	private:
+		struct Response
+		{
+			// the text without the value of request_id
+			std::string text;
+			// where the value of request_id goes
+			size_t id_pos = 0;
+		};
+
+		struct Entry
+		{
+			std::string key;
+			std::shared_ptr<const Response> response;
+		};
+
+		static size_t GetSize(const Entry& entry);
+
+	private:
+		size_t capacity_;
+		mutable std::mutex mutex_;
+		// the most recently used first
+		std::list<Entry> entries_;
+		// keys point to the keys of entries_
+		std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+		Stats stats_;
+	};
+}
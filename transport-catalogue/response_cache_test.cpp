@@ -0,0 +1,137 @@
+#include "response_cache.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	int failures = 0;
+
+	void Check(bool condition, std::string_view what)
+	{
+		if (!condition)
+		{
+			cerr << "FAILED: "sv << what << '\n';
+			++failures;
+		}
+	}
+
+	// the response for key with request_id, "-" if there is none
+	string Find(ResponseCache& cache, std::string_view key, int request_id)
+	{
+		string response;
+		return cache.Find(key, request_id, response) ? response : "-"s;
+	}
+
+	// request_id is cut out on Store and the new one spliced in on Find, wherever it is and however it is printed
+	void TestRequestId()
+	{
+		ResponseCache cache;
+		cache.Store("pretty"s, "{\n    \"request_id\": 5,\n    \"stop_count\": 4\n}"sv, 5);
+		cache.Store("compact"s, "{\"request_id\":17,\"stop_count\":4}"sv, 17);
+		cache.Store("last"s, "{\"name\":\"request_id\",\"request_id\":-3}"sv, -3);
+
+		Check(Find(cache, "pretty"sv, 123) == "{\n    \"request_id\": 123,\n    \"stop_count\": 4\n}"sv, "the id is replaced in a pretty response"sv);
+		Check(Find(cache, "compact"sv, -2147483647 - 1) == "{\"request_id\":-2147483648,\"stop_count\":4}"sv,
+			"the id is replaced in a compact response"sv);
+		Check(Find(cache, "last"sv, 2147483647) == "{\"name\":\"request_id\",\"request_id\":2147483647}"sv,
+			"the id is replaced at the end of the response"sv);
+
+		string response = "[\n"s;
+		Check(cache.Find("compact"sv, 1, response) && response == "[\n{\"request_id\":1,\"stop_count\":4}"sv,
+			"the response is appended to the buffer"sv);
+		Check(Find(cache, "unknown"sv, 1) == "-"sv, "an unknown key is not found"sv);
+	}
+
+	// responses the id can't be put back into are not stored
+	void TestNotStored()
+	{
+		ResponseCache cache(64);
+		cache.Store("no id"s, "{\"stop_count\":4}"sv, 1);
+		cache.Store("other id"s, "{\"request_id\":2}"sv, 1);
+		cache.Store("bad id"s, "{\"request_id\":x}"sv, 1);
+		cache.Store("too large"s, "{\"request_id\":1,\"map\":\"" + string(100, 'x') + "\"}", 1);
+		Check(Find(cache, "no id"sv, 1) == "-"sv, "a response without request_id is not stored"sv);
+		Check(Find(cache, "other id"sv, 1) == "-"sv, "a response with another request_id is not stored"sv);
+		Check(Find(cache, "bad id"sv, 1) == "-"sv, "a response with a malformed request_id is not stored"sv);
+		Check(Find(cache, "too large"sv, 1) == "-"sv, "a response larger than the capacity is not stored"sv);
+		Check(cache.GetStats().entries == 0 && cache.GetStats().bytes == 0, "nothing is stored"sv);
+	}
+
+	void TestEviction()
+	{
+		// every entry is a one-byte key and a 21-byte response without the id, three fit
+		const string response = "{\"request_id\":1,\"x\":0}";
+		ResponseCache cache(66);
+		cache.Store("a"s, response, 1);
+		cache.Store("b"s, response, 1);
+		cache.Store("c"s, response, 1);
+		Check(cache.GetStats().entries == 3 && cache.GetStats().bytes == 66, "three entries fit"sv);
+
+		// a hit makes a the most recently used, so b is the least recently used one
+		Check(Find(cache, "a"sv, 2) != "-"sv, "a is found"sv);
+		cache.Store("d"s, response, 1);
+		Check(Find(cache, "b"sv, 2) == "-"sv, "the least recently used entry is evicted"sv);
+		Check(Find(cache, "a"sv, 2) != "-"sv && Find(cache, "c"sv, 2) != "-"sv && Find(cache, "d"sv, 2) != "-"sv,
+			"the other entries stay"sv);
+
+		// a stored key is kept as it is
+		cache.Store("d"s, "{\"request_id\":1,\"y\":0}"sv, 1);
+		Check(Find(cache, "d"sv, 1) == response, "a key is stored once"sv);
+
+		const auto stats = cache.GetStats();
+		Check(stats.evictions == 1 && stats.entries == 3 && stats.bytes == 66, "the evictions and the size are counted"sv);
+		Check(stats.hits == 5 && stats.misses == 1, "the hits and the misses are counted"sv);
+	}
+
+	// several threads store and find the same keys, every hit has the right text and id
+	void TestThreads()
+	{
+		ResponseCache cache(2048);
+		vector<thread> threads;
+		vector<int> errors(4, 0);
+		for (size_t t = 0; t < errors.size(); t++)
+		{
+			threads.emplace_back([&cache, &error_count = errors[t], t]() {
+				for (int i = 0; i < 20000; i++)
+				{
+					const int key = (i * 7 + static_cast<int>(t)) % 300;
+					const int id = i;
+					const string expected = "{\"request_id\":"s + to_string(id) + ",\"key\":"s + to_string(key) + "}"s;
+					string response;
+					if (cache.Find(to_string(key), id, response))
+					{
+						error_count += response != expected;
+					}
+					else
+					{
+						cache.Store(to_string(key), expected, id);
+					}
+				}
+				});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		Check(errors == vector<int>(errors.size(), 0), "the responses found from several threads are right"sv);
+		Check(cache.GetStats().bytes <= 2048, "the size stays within the capacity"sv);
+	}
+}
+
+int main()
+{
+	TestRequestId();
+	TestNotStored();
+	TestEviction();
+	TestThreads();
+	if (failures == 0)
+	{
+		cerr << "response_cache_test OK"sv << '\n';
+	}
+	return failures == 0 ? 0 : 1;
+}
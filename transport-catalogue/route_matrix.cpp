@@ -0,0 +1,303 @@
+#include "route_matrix.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	void WriteVarint(uint64_t value, std::string& out)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<char>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+	uint64_t ReadVarint(const char*& pos, const char* end)
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (pos == end)
+			{
+				throw invalid_argument("Route row is truncated");
+			}
+			const auto byte = static_cast<uint8_t>(*pos++);
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (byte < 0x80)
+			{
+				return value;
+			}
+		}
+		throw invalid_argument("Route row has a too long number");
+	}
+
+	uint64_t ToBits(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	double FromBits(uint64_t bits)
+	{
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// small differences of either sign become small numbers
+	uint64_t ZigZag(uint64_t difference)
+	{
+		return (difference << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(difference) >> 63);
+	}
+
+	uint64_t UnZigZag(uint64_t value)
+	{
+		return (value >> 1) ^ (0 - (value & 1));
+	}
+}
+
+Transport::Routing::RouteRowCodec::RouteRowCodec(size_t vertex_count, const RouteEdge* edges, size_t edge_count)
+	: vertex_count_(vertex_count), incoming_offsets_(vertex_count + 1, 0), incoming_(edge_count)
+{
+	for (size_t i = 0; i < edge_count; i++)
+	{
+		if (edges[i].from >= vertex_count || edges[i].to >= vertex_count)
+		{
+			throw invalid_argument("Edge is outside the route matrix");
+		}
+		++incoming_offsets_[edges[i].to + 1];
+	}
+	for (size_t v = 0; v < vertex_count; v++)
+	{
+		incoming_offsets_[v + 1] += incoming_offsets_[v];
+	}
+	// edges are visited by id, so the edges of each vertex come out sorted
+	vector<uint32_t> positions(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+	for (size_t i = 0; i < edge_count; i++)
+	{
+		incoming_[positions[edges[i].to]++] = { edges[i].weight, static_cast<uint32_t>(i), edges[i].from };
+	}
+}
+
+template <typename Visit>
+void Transport::Routing::RouteRowCodec::VisitFromStart(const RouteCell* row, const std::vector<uint32_t>& incoming, Visit visit) const
+{
+	vector<bool> visited(vertex_count_, false);
+	vector<uint32_t> chain;
+	for (size_t to = 0; to < vertex_count_; to++)
+	{
+		// climb up to a visited route or the empty one, then visit the chain from the top
+		chain.clear();
+		for (size_t v = to; row[v].HasRoute() && !visited[v]; v = incoming_[incoming[v]].from)
+		{
+			chain.push_back(static_cast<uint32_t>(v));
+			if (incoming[v] == NO_INCOMING)
+			{
+				break;
+			}
+			if (chain.size() > vertex_count_)
+			{
+				throw invalid_argument("Routes of the row make a cycle");
+			}
+		}
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+		{
+			const uint32_t v = *it;
+			if (incoming[v] != NO_INCOMING && !row[incoming_[incoming[v]].from].HasRoute())
+			{
+				throw invalid_argument("Route continues a missing route");
+			}
+			visit(v, incoming[v]);
+			visited[v] = true;
+		}
+	}
+}
+
+void Transport::Routing::RouteRowCodec::Encode(const RouteCell* row, std::string& out) const
+{
+	// the last edges of the routes in order, with runs of missing routes
+	vector<uint32_t> incoming(vertex_count_, NO_INCOMING);
+	size_t missing = 0;
+	for (size_t to = 0; to < vertex_count_; to++)
+	{
+		if (!row[to].HasRoute())
+		{
+			++missing;
+			continue;
+		}
+		if (missing != 0)
+		{
+			WriteVarint(missing << 1 | 1, out);
+			missing = 0;
+		}
+		uint64_t code = 0;
+		if (row[to].prev_edge != RouteCell::NO_EDGE)
+		{
+			const auto begin = incoming_.begin() + incoming_offsets_[to];
+			const auto end = incoming_.begin() + incoming_offsets_[to + 1];
+			const auto it = lower_bound(begin, end, row[to].prev_edge,
+				[](const Incoming& lhv, uint32_t edge) { return lhv.edge < edge; });
+			if (it == end || it->edge != row[to].prev_edge)
+			{
+				throw invalid_argument("Route doesn't end with an edge entering its vertex");
+			}
+			incoming[to] = static_cast<uint32_t>(it - incoming_.begin());
+			code = incoming[to] - incoming_offsets_[to] + 1;
+		}
+		WriteVarint(code << 1, out);
+	}
+	// the weights follow, so the end of the row is marked too
+	if (missing != 0)
+	{
+		WriteVarint(missing << 1 | 1, out);
+	}
+
+	// then the weights, each after the weight it is predicted from
+	VisitFromStart(row, incoming, [this, row, &out](uint32_t v, uint32_t entry) {
+		const double predicted = entry == NO_INCOMING ? 0. : row[incoming_[entry].from].weight + incoming_[entry].weight;
+		WriteVarint(ZigZag(ToBits(row[v].weight) - ToBits(predicted)), out);
+	});
+}
+
+void Transport::Routing::RouteRowCodec::Decode(std::string_view data, RouteCell* row) const
+{
+	const char* pos = data.data();
+	const char* const end = data.data() + data.size();
+
+	vector<uint32_t> incoming(vertex_count_, NO_INCOMING);
+	fill(row, row + vertex_count_, RouteCell{});
+	for (size_t to = 0; to < vertex_count_; )
+	{
+		const uint64_t value = ReadVarint(pos, end);
+		if (value & 1)
+		{
+			if ((value >> 1) > vertex_count_ - to)
+			{
+				throw invalid_argument("Route row is too long");
+			}
+			to += value >> 1;
+			continue;
+		}
+		const uint64_t code = value >> 1;
+		if (code == 0)
+		{
+			row[to].prev_edge = RouteCell::NO_EDGE;
+		}
+		else
+		{
+			if (code > incoming_offsets_[to + 1] - incoming_offsets_[to])
+			{
+				throw invalid_argument("Route ends with an unknown edge");
+			}
+			incoming[to] = static_cast<uint32_t>(incoming_offsets_[to] + code - 1);
+			row[to].prev_edge = incoming_[incoming[to]].edge;
+		}
+		++to;
+	}
+
+	VisitFromStart(row, incoming, [this, row, &pos, end](uint32_t v, uint32_t entry) {
+		const double predicted = entry == NO_INCOMING ? 0. : row[incoming_[entry].from].weight + incoming_[entry].weight;
+		row[v].weight = FromBits(ToBits(predicted) + UnZigZag(ReadVarint(pos, end)));
+	});
+	if (pos != end)
+	{
+		throw invalid_argument("Route row has extra data");
+	}
+}
+
+Transport::Routing::RouteMatrix::DecodedRows::DecodedRows(size_t count)
+	: rows(new std::atomic<Cell*>[count]), count(count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		rows[i].store(nullptr, memory_order_relaxed);
+	}
+}
+
+Transport::Routing::RouteMatrix::DecodedRows::~DecodedRows()
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		delete[] rows[i].load(memory_order_relaxed);
+	}
+}
+
+Transport::Routing::RouteMatrix::RouteMatrix(size_t vertex_count, FlatArray<Cell> cells)
+	: vertex_count_(vertex_count), cells_(std::move(cells))
+{
+	if (cells_.size() != vertex_count_ * vertex_count_)
+	{
+		throw invalid_argument("Route matrix size doesn't match the vertex count");
+	}
+}
+
+Transport::Routing::RouteMatrix::RouteMatrix(size_t vertex_count, RouteRowCodec codec, std::vector<std::string> rows)
+	: vertex_count_(vertex_count), codec_(std::move(codec)), encoded_rows_(std::move(rows)),
+	decoded_rows_(make_unique<DecodedRows>(vertex_count))
+{
+	if (encoded_rows_.size() != vertex_count_)
+	{
+		throw invalid_argument("Route matrix size doesn't match the vertex count");
+	}
+}
+
+Transport::Routing::RouteMatrix::Cell Transport::Routing::RouteMatrix::MakeCell(const std::optional<graph::Router<double>::RouteInternalData>& route)
+{
+	Cell cell;
+	if (route)
+	{
+		cell.weight = route->weight;
+		cell.prev_edge = route->prev_edge ? static_cast<uint32_t>(*route->prev_edge) : NO_EDGE;
+	}
+	return cell;
+}
+
+size_t Transport::Routing::RouteMatrix::GetVertexCount() const
+{
+	return vertex_count_;
+}
+
+const Transport::Routing::RouteMatrix::Cell& Transport::Routing::RouteMatrix::Get(graph::VertexId from, graph::VertexId to) const
+{
+	if (from >= vertex_count_ || to >= vertex_count_)
+	{
+		throw out_of_range("Vertex is out of the route matrix");
+	}
+	return GetRow(from)[to];
+}
+
+const Transport::Routing::RouteMatrix::Cell* Transport::Routing::RouteMatrix::GetRow(graph::VertexId from) const
+{
+	if (!decoded_rows_)
+	{
+		return cells_.data() + from * vertex_count_;
+	}
+	if (const Cell* row = decoded_rows_->rows[from].load(memory_order_acquire))
+	{
+		return row;
+	}
+	return DecodeRow(from);
+}
+
+const Transport::Routing::RouteMatrix::Cell* Transport::Routing::RouteMatrix::DecodeRow(graph::VertexId from) const
+{
+	// not from the memory resource of the base, which may be a monotonic one that isn't thread safe
+	unique_ptr<Cell[]> row(new Cell[vertex_count_]);
+	codec_.Decode(encoded_rows_[from], row.get());
+
+	// threads decoding the same row at once keep the first copy
+	Cell* expected = nullptr;
+	if (decoded_rows_->rows[from].compare_exchange_strong(expected, row.get(), memory_order_acq_rel))
+	{
+		return row.release();
+	}
+	return expected;
+}
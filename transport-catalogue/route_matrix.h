@@ -0,0 +1,143 @@
+#pragma once
+
+#include "flat_array.h"
+#include "graph.h"
+#include "router.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Transport {
+	namespace Routing {
+
+		// an edge as the light router keeps it: a wait at stop name_id if span_count is 0,
+		// a ride over span_count spans on bus name_id otherwise
+		struct RouteEdge
+		{
+			double weight = 0;
+			uint32_t from = 0;
+			uint32_t to = 0;
+			uint32_t span_count = 0;
+			uint32_t name_id = 0;
+		};
+
+		// the shortest route from one vertex to another
+		struct RouteCell
+		{
+			static constexpr uint32_t NO_ROUTE = UINT32_MAX;
+			// prev_edge of the route from a vertex to itself
+			static constexpr uint32_t NO_EDGE = UINT32_MAX - 1;
+
+			double weight = 0.;
+			// the last edge of the route, NO_EDGE if the route is empty, NO_ROUTE if there is no route
+			uint32_t prev_edge = NO_ROUTE;
+			uint32_t reserved = 0;
+
+			bool HasRoute() const {
+				return prev_edge != NO_ROUTE;
+			}
+		};
+
+		// Compresses rows of the route matrix, knowing the edges of the graph. The last edge of a route
+		// is stored as its position among the edges entering the vertex, mostly 0 or a small number.
+		// Its weight is stored as the distance in units in the last place from the weight of the route
+		// to the start of the edge plus the edge weight, which is 0 unless the rounding differs, so
+		// the routes to the start come first. A run of missing routes takes a number.
+		// Each number is a varint, the weight distances, which may be negative, zigzag-coded first,
+		// so a route usually takes 2 bytes.
+		class RouteRowCodec
+		{
+		public:
+			RouteRowCodec() = default;
+
+			// throws std::invalid_argument if an edge is outside the vertices
+			RouteRowCodec(size_t vertex_count, const RouteEdge* edges, size_t edge_count);
+
+			// appends the row of vertex_count cells to out;
+			// throws std::invalid_argument if a route doesn't end with an edge entering its vertex
+			void Encode(const RouteCell* row, std::string& out) const;
+
+			// fills the row of vertex_count cells; throws std::invalid_argument if data is malformed
+			void Decode(std::string_view data, RouteCell* row) const;
+
+		private:
+			// an edge entering a vertex
+			struct Incoming
+			{
+				double weight = 0.;
+				uint32_t edge = 0;
+				uint32_t from = 0;
+			};
+
+			static constexpr uint32_t NO_INCOMING = UINT32_MAX;
+
+			// calls visit(vertex, incoming) for the routes of the row so that the route to the start of
+			// the incoming edge is visited first; incoming[v] is the index in incoming_ of the last edge
+			// of the route to v, NO_INCOMING if the route is empty
+			template <typename Visit>
+			void VisitFromStart(const RouteCell* row, const std::vector<uint32_t>& incoming, Visit visit) const;
+
+		private:
+			size_t vertex_count_ = 0;
+			// edges entering vertex v are incoming_[incoming_offsets_[v]] .. incoming_[incoming_offsets_[v + 1] - 1], by id
+			std::vector<uint32_t> incoming_offsets_;
+			std::vector<Incoming> incoming_;
+		};
+
+		// Shortest routes between all pairs of vertices, row `from` holds the routes from vertex from.
+		// The rows are either one block of V * V cells, half the size of the nested optionals the router
+		// computes and fit to be used in place, or compressed rows decoded on first use.
+		class RouteMatrix
+		{
+		public:
+			using Cell = RouteCell;
+
+			static constexpr uint32_t NO_ROUTE = RouteCell::NO_ROUTE;
+			static constexpr uint32_t NO_EDGE = RouteCell::NO_EDGE;
+
+			RouteMatrix() = default;
+
+			// cells.size() must be vertex_count * vertex_count
+			RouteMatrix(size_t vertex_count, FlatArray<Cell> cells);
+
+			// rows[i] is row i encoded by codec
+			RouteMatrix(size_t vertex_count, RouteRowCodec codec, std::vector<std::string> rows);
+
+			static Cell MakeCell(const std::optional<graph::Router<double>::RouteInternalData>& route);
+
+			size_t GetVertexCount() const;
+
+			// throws std::out_of_range for a vertex outside the matrix
+			const Cell& Get(graph::VertexId from, graph::VertexId to) const;
+
+			// vertex_count cells of the routes from the vertex; may be called from several threads at once
+			const Cell* GetRow(graph::VertexId from) const;
+
+		private:
+			// rows decoded so far, nullptr for the rest
+			struct DecodedRows
+			{
+				explicit DecodedRows(size_t count);
+				~DecodedRows();
+
+				std::unique_ptr<std::atomic<Cell*>[]> rows;
+				size_t count = 0;
+			};
+
+			const Cell* DecodeRow(graph::VertexId from) const;
+
+		private:
+			size_t vertex_count_ = 0;
+			FlatArray<Cell> cells_;
+
+			RouteRowCodec codec_;
+			std::vector<std::string> encoded_rows_;
+			std::unique_ptr<DecodedRows> decoded_rows_;
+		};
+	}
+}
@@ -0,0 +1,189 @@
+#include "route_matrix.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace Transport::Routing;
+using namespace std;
+
+namespace {
+	int failures = 0;
+
+	void Check(bool condition, std::string_view what)
+	{
+		if (!condition)
+		{
+			cerr << "FAILED: "sv << what << '\n';
+			++failures;
+		}
+	}
+
+	// checks that action throws std::invalid_argument with a message containing message
+	template <typename Action>
+	void CheckThrows(Action action, std::string_view message, std::string_view what)
+	{
+		try
+		{
+			action();
+		}
+		catch (const invalid_argument& e)
+		{
+			Check(string_view(e.what()).find(message) != string_view::npos, what);
+			return;
+		}
+		Check(false, what);
+	}
+
+	bool Equal(const RouteCell* lhv, const RouteCell* rhv, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (lhv[i].prev_edge != rhv[i].prev_edge || lhv[i].weight != rhv[i].weight)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// the shortest routes from vertex from, as the router makes them
+	vector<RouteCell> MakeRow(size_t vertex_count, const vector<RouteEdge>& edges, size_t from)
+	{
+		vector<RouteCell> row(vertex_count);
+		row[from].weight = 0.;
+		row[from].prev_edge = RouteCell::NO_EDGE;
+		for (bool changed = true; changed; )
+		{
+			changed = false;
+			for (size_t i = 0; i < edges.size(); i++)
+			{
+				const auto& edge = edges[i];
+				const double weight = row[edge.from].weight + edge.weight;
+				if (row[edge.from].HasRoute() && (!row[edge.to].HasRoute() || weight < row[edge.to].weight))
+				{
+					row[edge.to].weight = weight;
+					row[edge.to].prev_edge = static_cast<uint32_t>(i);
+					changed = true;
+				}
+			}
+		}
+		return row;
+	}
+
+	vector<RouteEdge> MakeEdges(size_t vertex_count, size_t edge_count, mt19937& generator)
+	{
+		uniform_int_distribution<uint32_t> vertex(0, static_cast<uint32_t>(vertex_count - 1));
+		uniform_real_distribution<double> weight(0.1, 30.);
+		vector<RouteEdge> edges(edge_count);
+		for (auto& edge : edges) {
+			edge.from = vertex(generator);
+			edge.to = vertex(generator);
+			edge.weight = weight(generator);
+		}
+		return edges;
+	}
+
+	void TestRoundTrip()
+	{
+		mt19937 generator(45);
+		for (int graph = 0; graph < 300; graph++)
+		{
+			const size_t vertex_count = uniform_int_distribution<size_t>(1, 40)(generator);
+			const size_t edge_count = uniform_int_distribution<size_t>(0, vertex_count * 3)(generator);
+			const auto edges = MakeEdges(vertex_count, edge_count, generator);
+			const RouteRowCodec codec(vertex_count, edges.data(), edges.size());
+
+			vector<vector<RouteCell>> rows;
+			vector<string> encoded_rows;
+			for (size_t from = 0; from < vertex_count; from++)
+			{
+				auto row = MakeRow(vertex_count, edges, from);
+				// a weight rounded another way than the prediction, of either sign
+				for (auto& cell : row) {
+					if (cell.HasRoute() && generator() % 4 == 0)
+					{
+						const int ulps = static_cast<int>(generator() % 5) - 2;
+						for (int i = 0; i < abs(ulps); i++)
+						{
+							cell.weight = nextafter(cell.weight, ulps < 0 ? -INFINITY : INFINITY);
+						}
+					}
+				}
+
+				string encoded;
+				codec.Encode(row.data(), encoded);
+				vector<RouteCell> decoded(vertex_count);
+				codec.Decode(encoded, decoded.data());
+				Check(Equal(row.data(), decoded.data(), vertex_count), "a row is decoded as it was encoded"sv);
+
+				rows.push_back(move(row));
+				encoded_rows.push_back(move(encoded));
+			}
+
+			const RouteMatrix matrix(vertex_count, codec, move(encoded_rows));
+			for (size_t from = 0; from < vertex_count; from++)
+			{
+				Check(Equal(rows[from].data(), matrix.GetRow(static_cast<graph::VertexId>(from)), vertex_count),
+					"the matrix decodes the rows"sv);
+			}
+		}
+	}
+
+	void TestMalformed()
+	{
+		// 0 -> 1, 1 -> 2, 2 -> 1
+		const vector<RouteEdge> edges = { { 1., 0, 1, 0, 0 }, { 1., 1, 2, 0, 0 }, { 1., 2, 1, 0, 0 } };
+		const RouteRowCodec codec(3, edges.data(), edges.size());
+		vector<RouteCell> row(3);
+
+		CheckThrows([]() {
+			const vector<RouteEdge> outside = { { 1., 0, 3, 0, 0 } };
+			RouteRowCodec(3, outside.data(), outside.size());
+			}, "outside"sv, "an edge outside the vertices is rejected"sv);
+
+		// routes 1 and 2 end with the edges between them, the weight of route 0 follows
+		const string cycle = { 0, 2 * 2, 2 * 1, 0 };
+		CheckThrows([&]() { codec.Decode(cycle, row.data()); }, "cycle"sv, "a cycle is rejected"sv);
+		const vector<RouteCell> cyclic = { { 0., RouteCell::NO_EDGE }, { 2., 2 }, { 3., 1 } };
+		CheckThrows([&]() { string out; codec.Encode(cyclic.data(), out); }, "cycle"sv, "a cycle is not encoded"sv);
+
+		// vertex 1 has two entering edges
+		const string unknown = { 0, 3 * 2, 1 | 1 * 2 };
+		CheckThrows([&]() { codec.Decode(unknown, row.data()); }, "unknown edge"sv, "an unknown edge is rejected"sv);
+		const vector<RouteCell> not_entering = { { 0., RouteCell::NO_EDGE }, { 1., 1 }, { 0., RouteCell::NO_ROUTE } };
+		CheckThrows([&]() { string out; codec.Encode(not_entering.data(), out); }, "entering"sv,
+			"an edge not entering the vertex is not encoded"sv);
+
+		const string too_long = { 0, 3 * 2 + 1 };
+		CheckThrows([&]() { codec.Decode(too_long, row.data()); }, "too long"sv, "a run past the row is rejected"sv);
+
+		const vector<RouteCell> valid = { { 0., RouteCell::NO_EDGE }, { 1., 0 }, { 2., 1 } };
+		string encoded;
+		codec.Encode(valid.data(), encoded);
+		codec.Decode(encoded, row.data());
+		Check(Equal(valid.data(), row.data(), row.size()), "the valid row is decoded"sv);
+		for (size_t size = 0; size < encoded.size(); size++)
+		{
+			CheckThrows([&]() { codec.Decode(string_view(encoded).substr(0, size), row.data()); }, "truncated"sv,
+				"a truncated row is rejected"sv);
+		}
+		CheckThrows([&]() { codec.Decode(encoded + '\0', row.data()); }, "extra data"sv, "extra data is rejected"sv);
+	}
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestMalformed();
+	if (failures == 0)
+	{
+		cerr << "route_matrix_test OK"sv << '\n';
+	}
+	return failures == 0 ? 0 : 1;
+}
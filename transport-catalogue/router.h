@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <memory_resource>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -25,9 +26,9 @@ namespace graph {
             std::optional<EdgeId> prev_edge;
         };
 
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        using RoutesInternalData = std::pmr::vector<std::pmr::vector<std::optional<RouteInternalData>>>;
 
-        explicit Router(const Graph& graph);
+        explicit Router(const Graph& graph, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
         struct RouteInfo {
             Weight weight;
@@ -86,10 +87,10 @@ namespace graph {
     };
 
     template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    Router<Weight>::Router(const Graph& graph, std::pmr::memory_resource* resource)
         : graph_(graph)
         , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+            std::pmr::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()), resource)
     {
         InitializeRoutesInternalData(graph);
 
@@ -1,15 +1,34 @@
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <future>
+#include <optional>
+#include <stdexcept>
 #include <unordered_map>
 #include <sstream>
 #include <variant>
 
 #include "serialization.h"
+#include "flat_base.h"
+#include "mapped_file.h"
 #include "map_renderer.h"
 #include "transport_router.h"
 #include "router.h"
+#include "request_handler.h"
 
-tc_serialization::Color SerializeColor(const svg::Color& color) {
-	tc_serialization::Color color_serialized;
+// a sectioned base starts with these bytes. No single-message base starts like it:
+// 'T' would be an end-group tag, so the older bases are still told apart
+const std::string_view SECTIONED_BASE_MAGIC = "TCSECT01";
+// the index size is stored at the end of the file in this many little-endian bytes
+constexpr size_t INDEX_SIZE_BYTES = 8;
+
+// make_base writes a section as messages of this many list items or row bytes at most,
+// so the whole section is never held in memory
+constexpr size_t CHUNK_ITEMS = 4096;
+constexpr size_t CHUNK_ROW_BYTES = 64 << 10;
+
+// fills color_serialized in place, so it may be a field of another message
+void SerializeColor(const svg::Color& color, tc_serialization::Color& color_serialized) {
 	if (std::holds_alternative<std::monostate>(color))
 	{
 		color_serialized.set_type("monostate");
@@ -36,11 +55,9 @@ tc_serialization::Color SerializeColor(const svg::Color& color) {
 		color_serialized.set_b(rgba_color.blue);
 		color_serialized.set_a(rgba_color.opacity);
 	}
-	return color_serialized;
 }
 
-void SerializeRenderSettings(tc_serialization::TransportCatalogue& catalogue_serialized, const Transport::Rendering::RenderSettings& settings) {
-	tc_serialization::RenderSettings settings_serialized;
+void SerializeRenderSettings(const Transport::Rendering::RenderSettings& settings, tc_serialization::RenderSettings& settings_serialized) {
 	settings_serialized.set_width(settings.width);
 	settings_serialized.set_height(settings.height);
 	settings_serialized.set_padding(settings.padding);
@@ -52,64 +69,183 @@ void SerializeRenderSettings(tc_serialization::TransportCatalogue& catalogue_ser
 	settings_serialized.set_stop_label_font_size(settings.stop_label_font_size);
 	settings_serialized.set_stop_label_x_offset(settings.stop_label_offset.x);
 	settings_serialized.set_stop_label_y_offset(settings.stop_label_offset.y);
-	*settings_serialized.mutable_underlayer_color() = SerializeColor(settings.underlayer_color);
-	for (auto color : settings.color_palette) {
-		settings_serialized.mutable_color_palette()->Add(std::move(SerializeColor(color)));
+	SerializeColor(settings.underlayer_color, *settings_serialized.mutable_underlayer_color());
+	for (const auto& color : settings.color_palette) {
+		SerializeColor(color, *settings_serialized.add_color_palette());
 	}
 	settings_serialized.set_underlayer_width(settings.underlayer_width);
-	*catalogue_serialized.mutable_render_settings() = std::move(settings_serialized);
 }
 
-void SerializeLightTransportRouter(const Transport::Routing::TransportRouter& transport_router, tc_serialization::TransportRouter& s_transport_router) {
+std::string serialization::SerializeRenderSettings(const Rendering::RenderSettings& settings)
+{
+	tc_serialization::RenderSettings settings_serialized;
+	::SerializeRenderSettings(settings, settings_serialized);
+	return settings_serialized.SerializeAsString();
+}
+
+void SerializeRouterSettings(const Transport::Routing::RouterSettings& settings, tc_serialization::RouterSettings& s_settings) {
+	s_settings.set_bus_wait_time(settings.bus_wait_time);
+	s_settings.set_bus_velocity(settings.bus_velocity);
+	s_settings.set_walking_velocity(settings.walking_velocity);
+	s_settings.set_walking_distance(settings.walking_distance);
+}
+
+// writes the sections one after another and the index of them after the last one.
+// A section may be written as several messages of its type: the parser merges
+// concatenated messages, appending the repeated fields, so the chunks read as one message
+class SectionWriter
+{
+public:
+	explicit SectionWriter(std::ostream& out)
+		: out_(out)
+	{
+		out_.write(SECTIONED_BASE_MAGIC.data(), SECTIONED_BASE_MAGIC.size());
+		offset_ = SECTIONED_BASE_MAGIC.size();
+	}
+
+	void Write(tc_serialization::BaseSectionKind kind, const google::protobuf::MessageLite& message) {
+		Begin(kind);
+		WriteChunk(message);
+		End();
+	}
+
+	// the bytes as they are, not a message
+	void WriteBytes(tc_serialization::BaseSectionKind kind, std::string_view bytes) {
+		Begin(kind);
+		out_.write(bytes.data(), bytes.size());
+		offset_ += bytes.size();
+		End();
+	}
+
+	void Begin(tc_serialization::BaseSectionKind kind) {
+		auto& section = *index_.add_section();
+		section.set_kind(kind);
+		section.set_offset(offset_);
+	}
+
+	void WriteChunk(const google::protobuf::MessageLite& message) {
+		// the buffer is reused, so it grows to the largest chunk once
+		message.SerializeToString(&buffer_);
+		if (buffer_.empty())
+		{
+			return;
+		}
+		out_.write(buffer_.data(), buffer_.size());
+		offset_ += buffer_.size();
+		index_.mutable_section()->rbegin()->add_chunk_size(buffer_.size());
+	}
+
+	void End() {
+		auto& section = *index_.mutable_section()->rbegin();
+		section.set_size(offset_ - section.offset());
+	}
+
+	void Finish() {
+		const std::string index = index_.SerializeAsString();
+		out_.write(index.data(), index.size());
+		uint64_t size = index.size();
+		char size_bytes[INDEX_SIZE_BYTES];
+		for (auto& byte : size_bytes) {
+			byte = static_cast<char>(size & 0xFF);
+			size >>= 8;
+		}
+		out_.write(size_bytes, sizeof(size_bytes));
+	}
+
+private:
+	std::ostream& out_;
+	uint64_t offset_ = 0;
+	tc_serialization::BaseIndex index_;
+	std::string buffer_;
+};
+
+// writes the router section in chunks
+void SerializeLightTransportRouter(const Transport::Routing::TransportRouter& transport_router, SectionWriter& writer) {
+	writer.Begin(tc_serialization::TRANSPORT_ROUTER);
+
+	// the cleared chunk keeps its items, so they are reused by the next one
+	tc_serialization::TransportRouter chunk;
+	const auto flush = [&writer, &chunk]() {
+		writer.WriteChunk(chunk);
+		chunk.Clear();
+	};
+
+	SerializeRouterSettings(transport_router.GetRouterSettings(), *chunk.mutable_settings());
+	const size_t vertex_count = transport_router.GetGraph().GetVertexCount();
+	chunk.set_vertex_count(vertex_count);
+
 	// serialize edges_info
 	for (auto& edge_info : transport_router.GetEdgesInfo()) {
-		tc_serialization::EdgeInfo s_edge_info;
-		s_edge_info.set_name(edge_info.name);
+		auto& s_edge_info = *chunk.add_edge_info();
+		s_edge_info.set_name(edge_info.name.data(), edge_info.name.size());
 		s_edge_info.set_span_count(edge_info.span_count);
 		s_edge_info.set_weight(edge_info.weight);
-		s_transport_router.mutable_edge_info()->Add(std::move(s_edge_info));
-	}
-
-	// serialize route_internal_data
-	s_transport_router.set_vertex_count(transport_router.GetGraph().GetVertexCount());
-
-	const auto& routes_data = transport_router.GetRouter().GetRoutesInternalData();
-	for (size_t i = 0; i < routes_data.size(); i++)
-	{
-		for (size_t j = 0; j < routes_data[0].size(); j++)
+		if (chunk.edge_info_size() == CHUNK_ITEMS)
 		{
-			tc_serialization::RouteInternalData s_route_data;
-			if (routes_data[i][j].has_value())
-			{
-				s_route_data.set_exist(true);
-				s_route_data.set_weight(routes_data[i][j].value().weight);
-				if (routes_data[i][j].value().prev_edge)
-				{
-					s_route_data.set_has_prev_edge(true);
-					s_route_data.set_prev_edge(routes_data[i][j].value().prev_edge.value());
-				}
-				else
-				{
-					s_route_data.set_has_prev_edge(false);
-				}
-			}
-			else
-			{
-				s_route_data.set_exist(false);
-			}
-			s_transport_router.mutable_route_internal_data()->Add(std::move(s_route_data));
+			flush();
 		}
 	}
+	flush();
 
 	// serialize graph
-	const auto graph = transport_router.GetGraph();
+	const auto& graph = transport_router.GetGraph();
 	for (auto edge : graph.GetEdges()) {
-		tc_serialization::Edge s_edge;
+		auto& s_edge = *chunk.add_edge();
 		s_edge.set_from(edge.from);
 		s_edge.set_to(edge.to);
 		s_edge.set_weight(edge.weight);
-		s_transport_router.mutable_edge()->Add(std::move(s_edge));
+		if (chunk.edge_size() == CHUNK_ITEMS)
+		{
+			flush();
+		}
+	}
+	flush();
+
+	// serialize the route matrix, compressed row by row
+	const auto route_edges = transport_router.GetRouteEdges();
+	const Transport::Routing::RouteRowCodec codec(vertex_count, route_edges.data(), route_edges.size());
+	std::vector<Transport::Routing::RouteMatrix::Cell> row;
+	size_t chunk_row_bytes = 0;
+	for (const auto& routes : transport_router.GetRouter().GetRoutesInternalData()) {
+		row.clear();
+		for (const auto& route : routes) {
+			row.push_back(Transport::Routing::RouteMatrix::MakeCell(route));
+		}
+		auto& s_row = *chunk.add_route_row();
+		codec.Encode(row.data(), s_row);
+		chunk_row_bytes += s_row.size();
+		if (chunk_row_bytes >= CHUNK_ROW_BYTES)
+		{
+			flush();
+			chunk_row_bytes = 0;
+		}
 	}
+	flush();
+
+	writer.End();
+}
+
+void SerializeNameIndex(const Transport::PerfectHash& index, tc_serialization::NameIndex& s_index) {
+	s_index.mutable_seed()->Add(index.GetSeeds().begin(), index.GetSeeds().end());
+	s_index.mutable_id()->Add(index.GetIds().begin(), index.GetIds().end());
+	s_index.mutable_fingerprint()->Add(index.GetFingerprints().begin(), index.GetFingerprints().end());
+	s_index.set_salt(index.GetSalt());
+}
+
+void SerializeSpatialIndex(const Transport::SpatialIndex& index, tc_serialization::SpatialIndex& s_index) {
+	const auto& grid = index.GetGrid();
+	s_index.set_min_lat(grid.min_lat);
+	s_index.set_min_lng(grid.min_lng);
+	s_index.set_cell_lat(grid.cell_lat);
+	s_index.set_cell_lng(grid.cell_lng);
+	s_index.set_rows(static_cast<uint32_t>(grid.rows));
+	s_index.set_cols(static_cast<uint32_t>(grid.cols));
+	s_index.mutable_cell_offset()->Add(index.GetCellOffsets().begin(), index.GetCellOffsets().end());
+	s_index.mutable_stop_id()->Add(index.GetIds().begin(), index.GetIds().end());
+}
+
+void SerializeSearchIndex(const Transport::NameSearchIndex& index, tc_serialization::SearchIndex& s_index) {
+	s_index.mutable_id()->Add(index.GetOrder().begin(), index.GetOrder().end());
 }
 
 void serialization::SerializeTransportCatalogue(const Transport::TransportCatalogue& catalogue, std::string filename, const Transport::Rendering::RenderSettings& render_settings,
@@ -123,71 +259,118 @@ void serialization::SerializeTransportCatalogue(const Transport::TransportCatalo
 	std::unordered_map<const Transport::Bus*, size_t> bus_to_id;
 	size_t bus_id_count = 0;
 
-	tc_serialization::TransportCatalogue catalogue_serialized;
+	SectionWriter writer(fout);
+	writer.Begin(tc_serialization::CATALOGUE);
+
+	tc_serialization::TransportCatalogue chunk;
+	// writes the chunk holding items alone; the cleared items stay allocated,
+	// so the next chunk fills them in place instead of allocating its own
+	const auto flush = [&writer, &chunk](auto& items) {
+		if (!items.empty())
+		{
+			writer.WriteChunk(chunk);
+			items.Clear();
+		}
+	};
 
 	// serialize stops
-	tc_serialization::StopList stop_list;
+	auto& stops_serialized = *chunk.mutable_stop_list()->mutable_stop();
 	for (const auto stop_ptr : catalogue.GetStops()) {
 		stop_to_id[stop_ptr] = stop_id_count++;
 
-		tc_serialization::Stop stop_serialized;
-		stop_serialized.set_name(stop_ptr->name);
+		auto& stop_serialized = *stops_serialized.Add();
+		stop_serialized.set_name(stop_ptr->name.data(), stop_ptr->name.size());
 		stop_serialized.set_stop_id(stop_to_id[stop_ptr]);
 		stop_serialized.set_lat_coord(stop_ptr->coords.lat);
 		stop_serialized.set_lng_coord(stop_ptr->coords.lng);
-
-		stop_list.mutable_stop()->Add(std::move(stop_serialized));
+		if (stops_serialized.size() == CHUNK_ITEMS)
+		{
+			flush(stops_serialized);
+		}
 	}
+	flush(stops_serialized);
+	chunk.clear_stop_list();
 
 	// serialize buses
-	tc_serialization::BusList bus_list;
+	auto& buses_serialized = *chunk.mutable_bus_list()->mutable_bus();
 	for (const auto& bus : catalogue.GetBuses()) {
 		bus_to_id[&bus] = bus_id_count++;
 
-		tc_serialization::Bus bus_serialized;
-		bus_serialized.set_name(bus.name);
+		auto& bus_serialized = *buses_serialized.Add();
+		bus_serialized.set_name(bus.name.data(), bus.name.size());
 		bus_serialized.set_bus_id(bus_to_id[&bus]);
 		bus_serialized.set_is_roundtrip(bus.is_roundtrip);
 		for (const auto stop_ptr : bus.stops) {
 			bus_serialized.mutable_stop_id()->Add(stop_to_id[stop_ptr]);
 		}
-
-		bus_list.mutable_bus()->Add(std::move(bus_serialized));
+		if (buses_serialized.size() == CHUNK_ITEMS)
+		{
+			flush(buses_serialized);
+		}
 	}
+	flush(buses_serialized);
+	chunk.clear_bus_list();
 
 	// serialize DistanceMap
-	tc_serialization::DistanceMap distance_map;
+	auto& distances_serialized = *chunk.mutable_distance_map()->mutable_distance();
 	for (const auto [stops, dist] : catalogue.GetDistanceMap()) {
-		tc_serialization::Distance distance_serialized;
+		auto& distance_serialized = *distances_serialized.Add();
 		distance_serialized.set_from(stop_to_id[stops.first]);
 		distance_serialized.set_to(stop_to_id[stops.second]);
 		distance_serialized.set_distance(dist);
-		distance_map.mutable_distance()->Add(std::move(distance_serialized));
+		if (distances_serialized.size() == CHUNK_ITEMS)
+		{
+			flush(distances_serialized);
+		}
 	}
+	flush(distances_serialized);
+	chunk.clear_distance_map();
 
 	// serialize StopRoutesMap
-	tc_serialization::StopRoutesMap stop_routes_map;
-	for (const auto [stop, buses] : catalogue.GetStopsToBuses()) {
-		tc_serialization::StopRoutes stop_routes;
+	auto& stop_routes_serialized = *chunk.mutable_stop_routes_map()->mutable_stop();
+	for (const auto stop : catalogue.GetStops()) {
+		const auto buses = catalogue.GetStopToBuses(stop);
+		if (buses.empty())
+		{
+			continue;
+		}
+		auto& stop_routes = *stop_routes_serialized.Add();
 		stop_routes.set_stop_id(stop_to_id[stop]);
 		for (const auto bus : buses) {
 			stop_routes.mutable_bus_id()->Add(bus_to_id[bus]);
 		}
-		stop_routes_map.mutable_stop()->Add(std::move(stop_routes));
+		if (stop_routes_serialized.size() == CHUNK_ITEMS)
+		{
+			flush(stop_routes_serialized);
+		}
 	}
+	flush(stop_routes_serialized);
+	chunk.clear_stop_routes_map();
+
+	// ids in the name indexes are the same as stop_id and bus_id above
+	SerializeNameIndex(catalogue.GetStopNameIndex(), *chunk.mutable_stop_name_index());
+	SerializeNameIndex(catalogue.GetBusNameIndex(), *chunk.mutable_bus_name_index());
+	SerializeSpatialIndex(catalogue.GetSpatialIndex(), *chunk.mutable_spatial_index());
+	SerializeSearchIndex(catalogue.GetStopSearchIndex(), *chunk.mutable_stop_search_index());
+	SerializeSearchIndex(catalogue.GetBusSearchIndex(), *chunk.mutable_bus_search_index());
+	writer.WriteChunk(chunk);
+	writer.End();
+
+	tc_serialization::RenderSettings render_settings_serialized;
+	::SerializeRenderSettings(render_settings, render_settings_serialized);
+	writer.Write(tc_serialization::RENDER_SETTINGS, render_settings_serialized);
 
-	*catalogue_serialized.mutable_stop_list() = std::move(stop_list);
-	*catalogue_serialized.mutable_bus_list() = std::move(bus_list);
-	*catalogue_serialized.mutable_distance_map() = std::move(distance_map);
-	*catalogue_serialized.mutable_stop_routes_map() = std::move(stop_routes_map);
-
-	//SerializeRenderSettings(catalogue_serialized, render_settings);
-	SerializeRenderSettings(catalogue_serialized, render_settings);
+	{
+		const auto map = Transport::Rendering::RenderMap(catalogue, render_settings);
+		writer.WriteBytes(tc_serialization::MAP_SVG, map.svg);
+		writer.WriteBytes(tc_serialization::MAP_JSON, map.json_escaped_svg);
+	}
 
-	Transport::Routing::TransportRouter router(catalogue, router_settings);
-	SerializeLightTransportRouter(router, *catalogue_serialized.mutable_transport_router());
+	// the router is built only after the catalogue section is written, and its rows are written as they are encoded
+	Transport::Routing::TransportRouter router(catalogue, router_settings, catalogue.GetMemoryResource());
+	SerializeLightTransportRouter(router, writer);
 
-	catalogue_serialized.SerializeToOstream(&fout);
+	writer.Finish();
 }
 
 svg::Color DeserializeColor(const tc_serialization::Color& color_serialized) {
@@ -215,8 +398,7 @@ svg::Color DeserializeColor(const tc_serialization::Color& color_serialized) {
 	}
 }
 
-void DeserializeRenderSettings(const tc_serialization::TransportCatalogue& catalogue_serialized, Transport::Rendering::RenderSettings& settings) {
-	auto& settings_serialized = catalogue_serialized.render_settings();
+void DeserializeRenderSettings(const tc_serialization::RenderSettings& settings_serialized, Transport::Rendering::RenderSettings& settings) {
 	settings.width = settings_serialized.width();
 	settings.height = settings_serialized.height();
 	settings.padding = settings_serialized.padding();
@@ -236,166 +418,533 @@ void DeserializeRenderSettings(const tc_serialization::TransportCatalogue& catal
 	}
 }
 
-Transport::Routing::LightTransportRouter DeserializeTransportRouter(const tc_serialization::TransportRouter& s_transport_router, const Transport::TransportCatalogue& catalogue) {
-	//  Transport_router
+void serialization::DeserializeRenderSettings(std::string_view data, Rendering::RenderSettings& settings)
+{
+	tc_serialization::RenderSettings settings_serialized;
+	if (!settings_serialized.ParseFromArray(data.data(), static_cast<int>(data.size())))
+	{
+		throw std::invalid_argument("Malformed base: can't parse the render settings");
+	}
+	::DeserializeRenderSettings(settings_serialized, settings);
+}
 
-	// deserialize edges_info
-	std::vector<Transport::Routing::EdgeInfo> edges_info;
-	const auto& s_edges_info = s_transport_router.edge_info();
-	for (size_t i = 0; i < s_transport_router.edge_info_size(); i++)
+Transport::Routing::RouterSettings DeserializeRouterSettings(const tc_serialization::RouterSettings& s_settings) {
+	Transport::Routing::RouterSettings settings;
+	settings.bus_wait_time = s_settings.bus_wait_time();
+	settings.bus_velocity = s_settings.bus_velocity();
+	// older bases have no walking settings, the defaults are used for them
+	if (s_settings.walking_velocity() > 0)
 	{
-		Transport::Routing::EdgeInfo ei;
-		ei.span_count = s_transport_router.edge_info(i).span_count();
-		ei.name = s_transport_router.edge_info(i).name();
-		ei.weight = s_transport_router.edge_info(i).weight();
-		edges_info.push_back(std::move(ei));
+		settings.walking_velocity = s_settings.walking_velocity();
+		settings.walking_distance = s_settings.walking_distance();
 	}
+	return settings;
+}
 
-	// deserialize route_internal_data
-	size_t vertex_count = s_transport_router.vertex_count();
+using RouterParts = std::vector<tc_serialization::TransportRouter*>;
 
-	graph::Router<double>::RoutesInternalData routes_data(vertex_count,
-		std::vector<std::optional<graph::Router<double>::RouteInternalData>>(vertex_count));
-	for (size_t i = 0; i < routes_data.size(); i++)
-	{
-		for (size_t j = 0; j < routes_data[0].size(); j++)
-		{
-			const auto& route = s_transport_router.route_internal_data(i * vertex_count + j);
-			if (route.exist())
+// the parts are the section split between threads, or the router of an older base; the rows are moved out of them
+Transport::Routing::LightTransportRouter DeserializeTransportRouter(const RouterParts& parts, const Transport::TransportCatalogue& catalogue,
+	std::pmr::memory_resource* resource) {
+	//  Transport_router
+
+	// the settings are written first
+	const auto& s_head = *parts.front();
+
+	// deserialize the edges together with their info, the i-th info and the i-th edge may be in different parts
+	size_t edge_count = 0;
+	for (const auto part : parts) {
+		edge_count += part->edge_info_size();
+	}
+	std::pmr::vector<Transport::Routing::RouteEdge> edges(edge_count, resource);
+	size_t edge_index = 0;
+	for (const auto part : parts) {
+		for (const auto& s_edge_info : part->edge_info()) {
+			auto& edge = edges[edge_index++];
+			edge.weight = s_edge_info.weight();
+			edge.span_count = s_edge_info.span_count();
+			// refer to the stop or the bus by id instead of copying the name
+			const auto& name = s_edge_info.name();
+			if (edge.span_count == 0)
 			{
-				if (route.has_prev_edge())
+				const auto stop = catalogue.GetStop(name);
+				if (!stop)
 				{
-					routes_data[i][j] = { route.weight(), route.prev_edge() };
+					throw std::invalid_argument("Malformed base: an edge refers to an unknown stop");
 				}
-				else
+				edge.name_id = static_cast<uint32_t>(stop->id);
+			}
+			else
+			{
+				const auto bus = catalogue.GetBus(name);
+				if (!bus)
 				{
-					routes_data[i][j] = { route.weight(), std::nullopt };
+					throw std::invalid_argument("Malformed base: an edge refers to an unknown bus");
 				}
+				edge.name_id = static_cast<uint32_t>(bus->id);
+			}
+		}
+	}
+	edge_index = 0;
+	for (const auto part : parts) {
+		for (const auto& s_edge : part->edge()) {
+			if (edge_index == edge_count)
+			{
+				throw std::invalid_argument("Malformed base: more edges than edge infos");
 			}
+			auto& edge = edges[edge_index++];
+			edge.from = s_edge.from();
+			edge.to = s_edge.to();
 		}
 	}
 
-	// deserialize graph
-	std::vector<graph::Edge<double>> edges;
-	for (size_t i = 0; i < s_transport_router.edge_size(); i++)
+	const size_t vertex_count = s_head.vertex_count();
+	const auto settings = DeserializeRouterSettings(s_head.settings());
+
+	// the rows are decoded when a route needs them
+	if (s_head.route_internal_data_size() == 0)
 	{
-		const auto& s_edge = s_transport_router.edge(i);
-		graph::Edge<double> edge;
-		edge.from = s_edge.from();
-		edge.to = s_edge.to();
-		edge.weight = s_edge.weight();
-		edges.push_back(std::move(edge));
+		Transport::Routing::RouteRowCodec codec(vertex_count, edges.data(), edges.size());
+		size_t row_count = 0;
+		for (const auto part : parts) {
+			row_count += part->route_row_size();
+		}
+		std::vector<std::string> rows;
+		rows.reserve(row_count);
+		for (const auto part : parts) {
+			for (auto& row : *part->mutable_route_row()) {
+				rows.push_back(std::move(row));
+			}
+		}
+		return Transport::Routing::LightTransportRouter(catalogue, settings,
+			Transport::FlatArray<Transport::Routing::RouteEdge>(std::move(edges)),
+			Transport::Routing::RouteMatrix(vertex_count, std::move(codec), std::move(rows)));
 	}
 
-	return Transport::Routing::LightTransportRouter(catalogue, edges_info, edges, routes_data);
+	// older bases store every route as a message
+	std::pmr::vector<Transport::Routing::RouteMatrix::Cell> cells(resource);
+	cells.reserve(vertex_count * vertex_count);
+	for (const auto& route : s_head.route_internal_data()) {
+		Transport::Routing::RouteMatrix::Cell cell;
+		if (route.exist())
+		{
+			cell.weight = route.weight();
+			cell.prev_edge = route.has_prev_edge() ? route.prev_edge() : Transport::Routing::RouteMatrix::NO_EDGE;
+		}
+		cells.push_back(cell);
+	}
+
+	return Transport::Routing::LightTransportRouter(catalogue, settings,
+		Transport::FlatArray<Transport::Routing::RouteEdge>(std::move(edges)),
+		Transport::Routing::RouteMatrix(vertex_count, Transport::FlatArray<Transport::Routing::RouteMatrix::Cell>(std::move(cells))));
 }
 
 struct SerializetionIdMap {
-	std::unordered_map<size_t, const Transport::Stop*> id_to_stop;
-	std::unordered_map<size_t, const Transport::Bus*> id_to_bus;
-	size_t stop_id_count = 0;
-	size_t bus_id_count = 0;
+	// read by several threads at once, so lookups don't insert
+	std::vector<const Transport::Stop*> id_to_stop;
+	std::vector<const Transport::Bus*> id_to_bus;
 };
 
-void DeserializeStops(const tc_serialization::StopList& s_stop_list, Transport::TransportCatalogue& catalogue, SerializetionIdMap& id_map) {
-	std::deque<Transport::Stop> stops;
+using CatalogueParts = std::vector<const tc_serialization::TransportCatalogue*>;
 
-	for (auto i = 0; i < s_stop_list.stop_size(); i++)
-	{
-		const auto& s_stop = s_stop_list.stop(i);
+void DeserializeStops(const CatalogueParts& parts, Transport::TransportCatalogue& catalogue, SerializetionIdMap& id_map) {
+	std::pmr::deque<Transport::Stop> stops(catalogue.GetMemoryResource());
 
-		Transport::Stop stop;
-		stop.name = s_stop.name();
-		stop.coords.lat = s_stop.lat_coord();
-		stop.coords.lng = s_stop.lng_coord();
+	for (const auto part : parts) {
+		for (const auto& s_stop : part->stop_list().stop()) {
+			Transport::Stop stop;
+			stop.name = s_stop.name();
+			stop.coords.lat = s_stop.lat_coord();
+			stop.coords.lng = s_stop.lng_coord();
 
-		stops.push_back(std::move(stop));
+			stops.push_back(std::move(stop));
+		}
 	}
 
 	catalogue.SetStops(std::move(stops));
 
-	for (auto stop_ptr : catalogue.GetStops()) {
-		id_map.id_to_stop[id_map.stop_id_count++] = stop_ptr;
+	id_map.id_to_stop = catalogue.GetStops();
+}
+
+void DeserializeBuses(const CatalogueParts& parts, Transport::TransportCatalogue& catalogue, SerializetionIdMap& id_map) {
+	std::pmr::deque<Transport::Bus> buses(catalogue.GetMemoryResource());
+
+	for (const auto part : parts) {
+		for (const auto& s_bus : part->bus_list().bus()) {
+			// moving a pmr vector keeps its resource, so the stop list is created with the catalogue's one
+			Transport::Bus bus{ s_bus.name(), std::pmr::vector<const Transport::Stop*>(catalogue.GetMemoryResource()) };
+			bus.is_roundtrip = s_bus.is_roundtrip();
+			bus.stops.reserve(s_bus.stop_id_size());
+			for (const auto stop_id : s_bus.stop_id()) {
+				bus.stops.push_back(id_map.id_to_stop.at(stop_id));
+			}
+
+			buses.push_back(std::move(bus));
+		}
+	}
+
+	catalogue.SetBuses(std::move(buses));
+
+	id_map.id_to_bus.reserve(catalogue.GetBuses().size());
+	for (const auto& bus : catalogue.GetBuses()) {
+		id_map.id_to_bus.push_back(&bus);
 	}
 }
 
-void DeserializeBuses(const tc_serialization::BusList& s_bus_list, Transport::TransportCatalogue& catalogue, SerializetionIdMap& id_map) {
-	std::deque<Transport::Bus> buses;
+void DeserializeDistanceMap(const CatalogueParts& parts, Transport::TransportCatalogue& catalogue, const SerializetionIdMap& id_map) {
+	Transport::TransportCatalogue::DistanceMap distance_map(catalogue.GetMemoryResource());
+	size_t distance_count = 0;
+	for (const auto part : parts) {
+		distance_count += part->distance_map().distance_size();
+	}
+	distance_map.reserve(distance_count);
 
-	for (auto i = 0; i < s_bus_list.bus_size(); i++)
-	{
-		const auto& s_bus = s_bus_list.bus(i);
+	for (const auto part : parts) {
+		for (const auto& s_distance : part->distance_map().distance()) {
+			auto from = id_map.id_to_stop.at(s_distance.from());
+			auto to = id_map.id_to_stop.at(s_distance.to());
+			distance_map[{from, to}] = s_distance.distance();
+		}
+	}
+
+	catalogue.SetDistanceMap(std::move(distance_map));
+}
 
-		Transport::Bus bus;
-		bus.name = s_bus.name();
-		bus.is_roundtrip = s_bus.is_roundtrip();
-		for (auto j = 0; j < s_bus.stop_id_size(); j++)
+void DeserializeStopRoutes(const CatalogueParts& parts, Transport::TransportCatalogue& catalogue, const SerializetionIdMap& id_map) {
+	// bus ids are stored in name order, so the rows are laid out as is
+	const size_t stops_count = catalogue.GetStopsCount();
+	std::vector<const tc_serialization::StopRoutes*> rows(stops_count, nullptr);
+	for (const auto part : parts) {
+		for (const auto& s_stop : part->stop_routes_map().stop()) {
+			rows.at(s_stop.stop_id()) = &s_stop;
+		}
+	}
+
+	Transport::TransportCatalogue::StopToBusesIndex stop_routes_index{
+		std::pmr::vector<size_t>(catalogue.GetMemoryResource()),
+		std::pmr::vector<const Transport::Bus*>(catalogue.GetMemoryResource()) };
+	stop_routes_index.offsets.reserve(stops_count + 1);
+	stop_routes_index.offsets.push_back(0);
+	for (const auto row : rows) {
+		if (row)
 		{
-			auto stop_id = s_bus.stop_id(j);
-			bus.stops.push_back(id_map.id_to_stop[stop_id]);
+			for (const auto bus_id : row->bus_id()) {
+				stop_routes_index.buses.push_back(id_map.id_to_bus.at(bus_id));
+			}
 		}
+		stop_routes_index.offsets.push_back(stop_routes_index.buses.size());
+	}
+
+	catalogue.SetStopToBuses(std::move(stop_routes_index));
+}
 
-		buses.push_back(std::move(bus));
+
+Transport::PerfectHash DeserializeNameIndex(const tc_serialization::NameIndex& s_index) {
+	return Transport::PerfectHash(
+		{ s_index.seed().begin(), s_index.seed().end() },
+		{ s_index.id().begin(), s_index.id().end() },
+		{ s_index.fingerprint().begin(), s_index.fingerprint().end() },
+		s_index.salt());
+}
+
+// the coordinates are taken from the already loaded stops
+Transport::SpatialIndex DeserializeSpatialIndex(const tc_serialization::SpatialIndex& s_index, const Transport::TransportCatalogue& catalogue) {
+	Transport::SpatialIndex::Grid grid;
+	grid.min_lat = s_index.min_lat();
+	grid.min_lng = s_index.min_lng();
+	grid.cell_lat = s_index.cell_lat();
+	grid.cell_lng = s_index.cell_lng();
+	grid.rows = s_index.rows();
+	grid.cols = s_index.cols();
+
+	std::vector<Geo::Coordinates> points;
+	points.reserve(catalogue.GetStopsCount());
+	for (const auto stop : catalogue.GetStops()) {
+		points.push_back(stop->coords);
 	}
 
-	catalogue.SetBuses(std::move(buses));
+	return Transport::SpatialIndex(grid,
+		{ s_index.cell_offset().begin(), s_index.cell_offset().end() },
+		{ s_index.stop_id().begin(), s_index.stop_id().end() },
+		points);
+}
 
+// the names are taken from the already loaded stops and buses
+std::pair<Transport::NameSearchIndex, Transport::NameSearchIndex> DeserializeSearchIndexes(const tc_serialization::TransportCatalogue& s_catalogue,
+	const Transport::TransportCatalogue& catalogue) {
+	std::vector<std::string_view> stop_names;
+	stop_names.reserve(catalogue.GetStopsCount());
+	for (const auto stop : catalogue.GetStops()) {
+		stop_names.push_back(stop->name);
+	}
+
+	std::vector<std::string_view> bus_names;
+	bus_names.reserve(catalogue.GetBuses().size());
 	for (const auto& bus : catalogue.GetBuses()) {
-		id_map.id_to_bus[id_map.bus_id_count++] = &bus;
+		bus_names.push_back(bus.name);
 	}
+
+	const auto& stop_order = s_catalogue.stop_search_index().id();
+	const auto& bus_order = s_catalogue.bus_search_index().id();
+	return { Transport::NameSearchIndex(stop_names, { stop_order.begin(), stop_order.end() }),
+		Transport::NameSearchIndex(bus_names, { bus_order.begin(), bus_order.end() }) };
 }
 
-void DeserializeDistanceMap(const tc_serialization::DistanceMap& s_distance_map, Transport::TransportCatalogue& catalogue, SerializetionIdMap& id_map) {
-	Transport::TransportCatalogue::DistanceMap distance_map;
+void DeserializeCatalogueInner(const CatalogueParts& parts, Transport::TransportCatalogue& catalogue, size_t thread_count) {
+	SerializetionIdMap id_map;
 
-	for (auto i = 0; i < s_distance_map.distance_size(); i++)
+	// the indexes are written in one chunk after the lists
+	const auto indexes_part = std::find_if(parts.begin(), parts.end(), [](const auto part) {
+		return part->has_stop_name_index();
+		});
+	const auto& s_indexes = indexes_part != parts.end() ? **indexes_part : *parts.back();
+
+	DeserializeStops(parts, catalogue, id_map);
+
+	// the indexes are built by other threads, which only read the stops and the buses meanwhile;
+	// this thread alone changes the catalogue and allocates from its memory resource
+	const auto launch = thread_count > 1 ? std::launch::async : std::launch::deferred;
+	auto name_indexes = std::async(launch, [&s_indexes]() {
+		return std::pair(DeserializeNameIndex(s_indexes.stop_name_index()), DeserializeNameIndex(s_indexes.bus_name_index()));
+		});
+	auto spatial_index = std::async(launch, [&s_indexes, &catalogue]() {
+		return DeserializeSpatialIndex(s_indexes.spatial_index(), catalogue);
+		});
+
+	DeserializeBuses(parts, catalogue, id_map);
+	auto search_indexes = std::async(launch, [&s_indexes, &catalogue]() {
+		return DeserializeSearchIndexes(s_indexes, catalogue);
+		});
+
+	DeserializeDistanceMap(parts, catalogue, id_map);
+	DeserializeStopRoutes(parts, catalogue, id_map);
+
+	auto [stop_name_index, bus_name_index] = name_indexes.get();
+	catalogue.SetNameIndexes(std::move(stop_name_index), std::move(bus_name_index));
+	catalogue.SetSpatialIndex(spatial_index.get());
+	auto [stop_search_index, bus_search_index] = search_indexes.get();
+	catalogue.SetSearchIndexes(std::move(stop_search_index), std::move(bus_search_index));
+
+	// older bases lack the indexes added later, so they are built as make_base does
+	if (!s_indexes.has_stop_name_index() || !s_indexes.has_bus_name_index())
 	{
-		const auto s_distance = s_distance_map.distance(i);
-		auto from = id_map.id_to_stop[s_distance.from()];
-		auto to = id_map.id_to_stop[s_distance.to()];
-		distance_map[{from, to}] = s_distance.distance();
+		catalogue.BuildNameIndexes();
+	}
+	if (!s_indexes.has_spatial_index())
+	{
+		catalogue.BuildSpatialIndex();
+	}
+	if (!s_indexes.has_stop_search_index() || !s_indexes.has_bus_search_index())
+	{
+		catalogue.BuildSearchIndexes();
 	}
-
-	catalogue.SetDistanceMap(distance_map);
 }
 
-void DeserializeStopRoutes(const tc_serialization::StopRoutesMap& s_stop_routes_map, Transport::TransportCatalogue& catalogue, SerializetionIdMap& id_map) {
-	Transport::TransportCatalogue::StopToRoutesMap stop_routes_map;
+struct BaseSections {
+	serialization::BaseFile::Section catalogue;
+	serialization::BaseFile::Section render_settings;
+	serialization::BaseFile::Section router;
+	Transport::Rendering::RenderedMapView map;
+};
+
+// the sections of a sectioned base, nullopt if data is not one;
+// throws std::invalid_argument if the index doesn't fit the data
+std::optional<BaseSections> FindSections(std::string_view data) {
+	if (data.substr(0, SECTIONED_BASE_MAGIC.size()) != SECTIONED_BASE_MAGIC)
+	{
+		return std::nullopt;
+	}
+	if (data.size() < SECTIONED_BASE_MAGIC.size() + INDEX_SIZE_BYTES)
+	{
+		throw std::invalid_argument("Malformed base: no section index");
+	}
+
+	const size_t index_end = data.size() - INDEX_SIZE_BYTES;
+	uint64_t index_size = 0;
+	for (size_t i = 0; i < INDEX_SIZE_BYTES; i++)
+	{
+		index_size |= uint64_t(static_cast<unsigned char>(data[index_end + i])) << (8 * i);
+	}
+	if (index_size > index_end - SECTIONED_BASE_MAGIC.size())
+	{
+		throw std::invalid_argument("Malformed base: the section index is out of the file");
+	}
 
-	for (auto i = 0; i < s_stop_routes_map.stop_size(); i++)
+	tc_serialization::BaseIndex index;
+	if (!index.ParseFromArray(data.data() + index_end - index_size, static_cast<int>(index_size)))
 	{
-		const auto s_stop = s_stop_routes_map.stop(i);
-		auto stop_ptr = id_map.id_to_stop[s_stop.stop_id()];
-		for (auto j = 0; j < s_stop.bus_id_size(); j++)
+		throw std::invalid_argument("Malformed base: can't parse the section index");
+	}
+
+	BaseSections sections;
+	for (const auto& section : index.section()) {
+		if (section.offset() > index_end || section.size() > index_end - section.offset())
+		{
+			throw std::invalid_argument("Malformed base: a section is out of the file");
+		}
+		uint64_t chunks_size = 0;
+		for (const auto chunk_size : section.chunk_size()) {
+			chunks_size += chunk_size;
+		}
+		if (chunks_size != section.size() && section.chunk_size_size() != 0)
 		{
-			auto bus_ptr = id_map.id_to_bus[s_stop.bus_id(j)];
-			stop_routes_map[stop_ptr].insert(bus_ptr);
+			throw std::invalid_argument("Malformed base: the chunks don't fill their section");
+		}
+		const serialization::BaseFile::Section section_data{ data.substr(section.offset(), section.size()),
+			{ section.chunk_size().begin(), section.chunk_size().end() } };
+		switch (section.kind())
+		{
+		case tc_serialization::CATALOGUE:
+			sections.catalogue = section_data;
+			break;
+		case tc_serialization::RENDER_SETTINGS:
+			sections.render_settings = section_data;
+			break;
+		case tc_serialization::TRANSPORT_ROUTER:
+			sections.router = section_data;
+			break;
+		case tc_serialization::MAP_SVG:
+			sections.map.svg = section_data.data;
+			break;
+		case tc_serialization::MAP_JSON:
+			sections.map.json_escaped_svg = section_data.data;
+			break;
+		default:
+			// sections added later are of no use here
+			break;
 		}
 	}
-
-	catalogue.SetStopToBuses(std::move(stop_routes_map));
+	return sections;
 }
 
+template <typename Message>
+void ParseSection(std::string_view data, Message& message) {
+	if (!message.ParseFromArray(data.data(), static_cast<int>(data.size())))
+	{
+		throw std::invalid_argument("Malformed base: can't parse a section");
+	}
+}
 
-void DeserializeCatalogueInner(const tc_serialization::TransportCatalogue& s_catalogue, Transport::TransportCatalogue& catalogue) {
-	SerializetionIdMap id_map;
+google::protobuf::ArenaOptions SectionArenaOptions() {
+	google::protobuf::ArenaOptions options;
+	options.start_block_size = 64 << 10;
+	options.max_block_size = 1 << 20;
+	return options;
+}
 
-	DeserializeStops(s_catalogue.stop_list(), catalogue, id_map);
-	DeserializeBuses(s_catalogue.bus_list(), catalogue, id_map);
-	DeserializeDistanceMap(s_catalogue.distance_map(), catalogue, id_map);
-	DeserializeStopRoutes(s_catalogue.stop_routes_map(), catalogue, id_map);
+// fewer bytes of a section per thread are not worth starting a thread
+constexpr size_t MIN_SECTION_BYTES_PER_THREAD = 256 << 10;
+
+// parses the section in up to thread_count contiguous runs of its chunks at once, each run
+// into a message of its own on arena; the parts are in the order of the section
+template <typename Message>
+std::vector<Message*> ParseSectionParts(const serialization::BaseFile::Section& section, size_t thread_count, google::protobuf::Arena& arena) {
+	const size_t size = section.data.size();
+	const size_t range_count = std::clamp<size_t>(size / MIN_SECTION_BYTES_PER_THREAD, 1, std::max<size_t>(thread_count, 1));
+
+	// a run ends at the first chunk boundary past its share of the bytes
+	std::vector<size_t> range_begins{ 0 };
+	size_t offset = 0;
+	for (const auto chunk_size : section.chunk_sizes) {
+		if (offset != 0 && range_begins.size() < range_count && offset >= size * range_begins.size() / range_count)
+		{
+			range_begins.push_back(offset);
+		}
+		offset += chunk_size;
+	}
+	range_begins.push_back(size);
+
+	// the arena is thread-safe, each thread allocates from blocks of its own
+	std::vector<Message*> parts(range_begins.size() - 1);
+	const auto parse = [&section, &range_begins, &parts, &arena](size_t range) {
+		parts[range] = google::protobuf::Arena::CreateMessage<Message>(&arena);
+		ParseSection(section.data.substr(range_begins[range], range_begins[range + 1] - range_begins[range]), *parts[range]);
+	};
+	std::vector<std::future<void>> ranges;
+	for (size_t range = 1; range < parts.size(); range++)
+	{
+		ranges.push_back(std::async(std::launch::async, parse, range));
+	}
+	parse(0);
+	for (auto& range : ranges) {
+		range.get();
+	}
+	return parts;
 }
 
-Transport::Routing::LightTransportRouter serialization::DeserializeTransportCatalogue(std::string filename, Transport::TransportCatalogue& catalogue, Rendering::RenderSettings& render_settings)
+serialization::BaseFile::BaseFile(const std::string& filename, Transport::TransportCatalogue& catalogue, std::pmr::memory_resource* resource,
+	size_t thread_count)
+	: catalogue_(catalogue), resource_(resource), thread_count_(thread_count)
 {
-	std::ifstream fin(filename, std::ios::binary);
+	// the flat base is used in place, the routes are looked up at random
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		char magic[FLAT_BASE_MAGIC_SIZE] = {};
+		if (fin.read(magic, sizeof(magic)) && IsFlatBase({ magic, sizeof(magic) }))
+		{
+			router_.emplace(DeserializeFlatBase(std::make_shared<const Transport::MappedFile>(filename, Transport::MappedFile::Access::RANDOM),
+				catalogue, render_settings_, map_));
+			return;
+		}
+	}
 
-	tc_serialization::TransportCatalogue s_catalogue;
-	s_catalogue.ParseFromIstream(&fin);
+	auto file = std::make_shared<const Transport::MappedFile>(filename);
+	const auto data = file->GetData();
 
-	DeserializeCatalogueInner(s_catalogue, catalogue);
+	// the parsed messages are freed at once with the arena, instead of one by one
+	google::protobuf::Arena arena(SectionArenaOptions());
 
-	DeserializeRenderSettings(s_catalogue, render_settings);
+	if (auto sections = FindSections(data))
+	{
+		const auto parts = ParseSectionParts<tc_serialization::TransportCatalogue>(sections->catalogue, thread_count, arena);
+		DeserializeCatalogueInner({ parts.begin(), parts.end() }, catalogue, thread_count);
+
+		file_ = std::move(file);
+		render_settings_section_ = sections->render_settings.data;
+		router_section_ = std::move(sections->router);
+		map_ = sections->map;
+		return;
+	}
 
-	return DeserializeTransportRouter(s_catalogue.transport_router(), catalogue);
+	// older bases hold everything in one message, so it is read at once
+	auto s_catalogue = google::protobuf::Arena::CreateMessage<tc_serialization::TransportCatalogue>(&arena);
+	if (!s_catalogue->ParseFromArray(data.data(), static_cast<int>(data.size())))
+	{
+		throw std::invalid_argument("Malformed base: can't parse the catalogue");
+	}
+
+	DeserializeCatalogueInner({ s_catalogue }, catalogue, thread_count);
+
+	::DeserializeRenderSettings(s_catalogue->render_settings(), render_settings_);
+
+	router_.emplace(DeserializeTransportRouter({ s_catalogue->mutable_transport_router() }, catalogue, resource));
+}
+
+const Transport::Rendering::RenderedMapView& serialization::BaseFile::GetMap() const
+{
+	return map_;
+}
+
+const Transport::Rendering::RenderSettings& serialization::BaseFile::GetRenderSettings() const
+{
+	std::call_once(render_settings_once_, [this] {
+		if (file_)
+		{
+			DeserializeRenderSettings(render_settings_section_, render_settings_);
+		}
+		});
+	return render_settings_;
+}
+
+const Transport::Routing::LightTransportRouter& serialization::BaseFile::GetRouter() const
+{
+	std::call_once(router_once_, [this] {
+		if (!router_)
+		{
+			google::protobuf::Arena arena(SectionArenaOptions());
+			const auto parts = ParseSectionParts<tc_serialization::TransportRouter>(router_section_, thread_count_, arena);
+			router_.emplace(DeserializeTransportRouter(parts, catalogue_, resource_));
+		}
+		});
+	return *router_;
 }
@@ -1,27 +1,75 @@
 #pragma once
 
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 #include <transport_catalogue.pb.h>
 #include "transport_catalogue.h"
 #include "map_renderer.h"
-
-namespace Transport {
-    namespace Rendering {
-        class RenderSettings;
-    }
-    namespace Routing {
-        class RouterSettings;
-        class LightTransportRouter;
-    }
-}
+#include "mapped_file.h"
+#include "request_handler.h"
+#include "transport_router.h"
 
 using namespace Transport;
 
 namespace serialization {
+	// writes the catalogue, the render settings and the router as separate sections,
+	// so the loader can leave the ones a batch doesn't need unread
 	void SerializeTransportCatalogue(const TransportCatalogue& catalogue, std::string filename,
 		const Rendering::RenderSettings& render_settings,
 		const Routing::RouterSettings& router_settings);
 
-	Routing::LightTransportRouter DeserializeTransportCatalogue(std::string filename,
-		Transport::TransportCatalogue& catalogue, Rendering::RenderSettings& render_settings);
+	// A loaded base: the sectioned, the older single-message or the flat one. The constructor fills
+	// the catalogue; the render settings and the router of a sectioned base are read from the file
+	// when they are first asked for, so a batch of Bus and Stop requests never reads them
+	class BaseFile
+	{
+	public:
+		// a section in the file
+		struct Section
+		{
+			std::string_view data;
+			// the sizes of the messages the section is written as
+			std::vector<size_t> chunk_sizes;
+		};
+
+		// the router is allocated from resource, the catalogue from its own memory resource;
+		// a flat base router uses the mapped file instead. A large section is parsed and
+		// assembled in up to thread_count threads. Throws std::system_error if the file
+		// can't be read and std::invalid_argument if the sections are malformed
+		BaseFile(const std::string& filename, TransportCatalogue& catalogue,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource(), size_t thread_count = 1);
+		BaseFile(const BaseFile&) = delete;
+		BaseFile& operator=(const BaseFile&) = delete;
+
+		// the map rendered by make_base, in the file; empty for a base written before
+		const Rendering::RenderedMapView& GetMap() const;
+
+		// safe to call from several threads, the section is read by the first call
+		const Rendering::RenderSettings& GetRenderSettings() const;
+		const Routing::LightTransportRouter& GetRouter() const;
+
+	private:
+		const TransportCatalogue& catalogue_;
+		std::pmr::memory_resource* resource_;
+		size_t thread_count_;
+		// the sections not read yet point into the file
+		std::shared_ptr<const MappedFile> file_;
+		std::string_view render_settings_section_;
+		Section router_section_;
+		Rendering::RenderedMapView map_;
+
+		mutable std::once_flag render_settings_once_;
+		mutable std::once_flag router_once_;
+		mutable Rendering::RenderSettings render_settings_;
+		mutable std::optional<Routing::LightTransportRouter> router_;
+	};
+
+	// the render settings alone, as the flat base stores them
+	std::string SerializeRenderSettings(const Rendering::RenderSettings& settings);
+	void DeserializeRenderSettings(std::string_view data, Rendering::RenderSettings& settings);
 }
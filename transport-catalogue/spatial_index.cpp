@@ -0,0 +1,323 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	// the same constants as in Geo::ComputeDistance
+	const double DEGREE = 3.1415926535 / 180.;
+	const double METERS_PER_DEGREE = 6371000 * DEGREE;
+
+	// average number of points in a cell
+	const double CELL_LOAD = 2.;
+
+	double GetDistance(Geo::Coordinates from, Geo::Coordinates to)
+	{
+		const double distance = Geo::ComputeDistance(from, to);
+		// acos of a value rounded slightly above 1 for almost equal points
+		return std::isnan(distance) ? 0. : distance;
+	}
+
+	bool IsCloser(const NearbyPoint& lhv, const NearbyPoint& rhv)
+	{
+		return std::make_pair(lhv.distance, lhv.id) < std::make_pair(rhv.distance, rhv.id);
+	}
+
+	// nearest first, a point found from several positions once; its distances are equal,
+	// since they are measured from the same center
+	void SortUnique(vector<NearbyPoint>& points)
+	{
+		sort(points.begin(), points.end(), IsCloser);
+		points.erase(unique(points.begin(), points.end(), [](const auto& lhv, const auto& rhv) {
+			return lhv.id == rhv.id;
+			}), points.end());
+	}
+
+	// the position itself and the position a turn east and west of it
+	const double LNG_SHIFTS[] = { 0., 360., -360. };
+}
+
+Transport::SpatialIndex::SpatialIndex(const std::vector<Geo::Coordinates>& points)
+{
+	if (points.empty())
+	{
+		return;
+	}
+
+	const auto [bottom_it, top_it] = minmax_element(points.begin(), points.end(),
+		[](const auto& lhv, const auto& rhv) { return lhv.lat < rhv.lat; });
+	const auto [left_it, right_it] = minmax_element(points.begin(), points.end(),
+		[](const auto& lhv, const auto& rhv) { return lhv.lng < rhv.lng; });
+	const double lat_span = top_it->lat - bottom_it->lat;
+	const double lng_span = right_it->lng - left_it->lng;
+
+	// square cells in meters, about CELL_LOAD points per cell
+	const double cells = max(1., points.size() / CELL_LOAD);
+	const double height = lat_span * METERS_PER_DEGREE;
+	const double width = lng_span * METERS_PER_DEGREE * cos((top_it->lat + bottom_it->lat) / 2 * DEGREE);
+	const double side = height > 0 && width > 0 ? sqrt(height * width / cells) : max(height, width) / cells;
+
+	grid_.min_lat = bottom_it->lat;
+	grid_.min_lng = left_it->lng;
+	// an axis of almost no span would otherwise get a huge number of thin cells;
+	// rows * cols is cells, so when one axis is capped the other has a single cell
+	const double max_cells = ceil(cells);
+	grid_.rows = side > 0 ? max<size_t>(1, static_cast<size_t>(min(ceil(height / side), max_cells))) : 1;
+	grid_.cols = side > 0 ? max<size_t>(1, static_cast<size_t>(min(ceil(width / side), max_cells))) : 1;
+	grid_.cell_lat = lat_span > 0 ? lat_span / grid_.rows : 1.;
+	grid_.cell_lng = lng_span > 0 ? lng_span / grid_.cols : 1.;
+
+	// counting sort of the points by cell
+	vector<size_t> point_cells(points.size());
+	cell_offsets_.assign(grid_.rows * grid_.cols + 1, 0);
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		point_cells[i] = GetRow(points[i].lat) * grid_.cols + GetCol(points[i].lng);
+		++cell_offsets_[point_cells[i] + 1];
+	}
+	for (size_t i = 1; i < cell_offsets_.size(); i++)
+	{
+		cell_offsets_[i] += cell_offsets_[i - 1];
+	}
+
+	vector<uint32_t> positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+	ids_.resize(points.size());
+	points_.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const size_t position = positions[point_cells[i]]++;
+		ids_[position] = static_cast<uint32_t>(i);
+		points_[position] = points[i];
+	}
+}
+
+Transport::SpatialIndex::SpatialIndex(Grid grid, std::vector<uint32_t> cell_offsets, std::vector<uint32_t> ids,
+	const std::vector<Geo::Coordinates>& points)
+	: grid_(grid), cell_offsets_(std::move(cell_offsets)), ids_(std::move(ids))
+{
+	points_.reserve(ids_.size());
+	for (const auto id : ids_) {
+		points_.push_back(points.at(id));
+	}
+}
+
+std::vector<NearbyPoint> Transport::SpatialIndex::FindInRadius(Geo::Coordinates center, double radius) const
+{
+	vector<NearbyPoint> result;
+	if (points_.empty() || radius < 0)
+	{
+		return result;
+	}
+
+	for (const double shift : LNG_SHIFTS) {
+		const Geo::Coordinates position{ center.lat, center.lng + shift };
+		if (shift == 0. || DistanceToGrid(position) <= radius)
+		{
+			CollectInRadius(position, center, radius, result);
+		}
+	}
+	SortUnique(result);
+	return result;
+}
+
+std::vector<NearbyPoint> Transport::SpatialIndex::FindNearest(Geo::Coordinates center, size_t count, std::optional<double> radius) const
+{
+	vector<NearbyPoint> result;
+	if (points_.empty() || count == 0)
+	{
+		return result;
+	}
+	const double max_distance = radius.value_or(numeric_limits<double>::infinity());
+
+	vector<NearbyPoint> found;
+	for (const double shift : LNG_SHIFTS) {
+		const Geo::Coordinates position{ center.lat, center.lng + shift };
+		// the points found from the other positions bound the search, result is sorted
+		const double bound = result.size() >= count ? result[count - 1].distance : max_distance;
+		if (shift != 0. && (result.size() == points_.size() || DistanceToGrid(position) > bound))
+		{
+			continue;
+		}
+		// each search stops on its own candidates, which the points already found would duplicate
+		found.clear();
+		CollectNearest(position, center, count, max_distance, found);
+		result.insert(result.end(), found.begin(), found.end());
+		SortUnique(result);
+	}
+
+	if (result.size() > count)
+	{
+		result.resize(count);
+	}
+	return result;
+}
+
+const SpatialIndex::Grid& Transport::SpatialIndex::GetGrid() const
+{
+	return grid_;
+}
+
+const std::vector<uint32_t>& Transport::SpatialIndex::GetCellOffsets() const
+{
+	return cell_offsets_;
+}
+
+const std::vector<uint32_t>& Transport::SpatialIndex::GetIds() const
+{
+	return ids_;
+}
+
+size_t Transport::SpatialIndex::GetRow(double lat) const
+{
+	const double row = floor((lat - grid_.min_lat) / grid_.cell_lat);
+	return static_cast<size_t>(clamp(row, 0., static_cast<double>(grid_.rows - 1)));
+}
+
+size_t Transport::SpatialIndex::GetCol(double lng) const
+{
+	const double col = floor((lng - grid_.min_lng) / grid_.cell_lng);
+	return static_cast<size_t>(clamp(col, 0., static_cast<double>(grid_.cols - 1)));
+}
+
+void Transport::SpatialIndex::CollectInRadius(Geo::Coordinates position, Geo::Coordinates center, double radius,
+	std::vector<NearbyPoint>& result) const
+{
+	// a degree of longitude is shortest at the latitude farthest from the equator
+	const double lat_delta = radius / METERS_PER_DEGREE;
+	const double max_abs_lat = max(abs(position.lat - lat_delta), abs(position.lat + lat_delta));
+	const double lng_meters = METERS_PER_DEGREE * cos(min(max_abs_lat, 90.) * DEGREE);
+
+	CellRange range{ GetRow(position.lat - lat_delta), GetRow(position.lat + lat_delta), 0, grid_.cols - 1 };
+	if (lng_meters > 0 && radius / lng_meters < 180.)
+	{
+		const double lng_delta = radius / lng_meters;
+		range.col_from = GetCol(position.lng - lng_delta);
+		range.col_to = GetCol(position.lng + lng_delta);
+	}
+
+	CollectCells(range, center, radius, result);
+}
+
+void Transport::SpatialIndex::CollectNearest(Geo::Coordinates position, Geo::Coordinates center, size_t count, double max_distance,
+	std::vector<NearbyPoint>& result) const
+{
+	const size_t row = GetRow(position.lat);
+	const size_t col = GetCol(position.lng);
+	CellRange range{ row, row, col, col };
+	CollectCells(range, center, max_distance, result);
+
+	// grow the searched block ring by ring until no unvisited cell can hold a closer point
+	while (true)
+	{
+		const double outside = DistanceOutside(range, position);
+		if (outside > max_distance)
+		{
+			break;
+		}
+		if (result.size() >= count)
+		{
+			nth_element(result.begin(), result.begin() + (count - 1), result.end(), IsCloser);
+			if (result[count - 1].distance <= outside)
+			{
+				break;
+			}
+		}
+
+		CellRange next{
+			range.row_from > 0 ? range.row_from - 1 : 0,
+			min(range.row_to + 1, grid_.rows - 1),
+			range.col_from > 0 ? range.col_from - 1 : 0,
+			min(range.col_to + 1, grid_.cols - 1) };
+		// the whole grid is searched, fewer than count points are within max_distance
+		if (next.row_from == range.row_from && next.row_to == range.row_to
+			&& next.col_from == range.col_from && next.col_to == range.col_to)
+		{
+			break;
+		}
+
+		if (next.row_from < range.row_from)
+		{
+			CollectCells({ next.row_from, next.row_from, next.col_from, next.col_to }, center, max_distance, result);
+		}
+		if (next.row_to > range.row_to)
+		{
+			CollectCells({ next.row_to, next.row_to, next.col_from, next.col_to }, center, max_distance, result);
+		}
+		if (next.col_from < range.col_from)
+		{
+			CollectCells({ range.row_from, range.row_to, next.col_from, next.col_from }, center, max_distance, result);
+		}
+		if (next.col_to > range.col_to)
+		{
+			CollectCells({ range.row_from, range.row_to, next.col_to, next.col_to }, center, max_distance, result);
+		}
+		range = next;
+	}
+}
+
+void Transport::SpatialIndex::CollectCells(const CellRange& range, Geo::Coordinates center, double radius,
+	std::vector<NearbyPoint>& result) const
+{
+	for (size_t row = range.row_from; row <= range.row_to; row++)
+	{
+		// the cells of a row are contiguous
+		const size_t begin = cell_offsets_[row * grid_.cols + range.col_from];
+		const size_t end = cell_offsets_[row * grid_.cols + range.col_to + 1];
+		for (size_t i = begin; i < end; i++)
+		{
+			const double distance = GetDistance(center, points_[i]);
+			if (distance <= radius)
+			{
+				result.push_back({ ids_[i], distance });
+			}
+		}
+	}
+}
+
+double Transport::SpatialIndex::DistanceOutside(const CellRange& range, Geo::Coordinates position) const
+{
+	const double lng_meters = GetLngMeters(position);
+
+	double distance = numeric_limits<double>::infinity();
+	if (range.row_from > 0)
+	{
+		const double edge = grid_.min_lat + range.row_from * grid_.cell_lat;
+		distance = min(distance, max(0., position.lat - edge) * METERS_PER_DEGREE);
+	}
+	if (range.row_to + 1 < grid_.rows)
+	{
+		const double edge = grid_.min_lat + (range.row_to + 1) * grid_.cell_lat;
+		distance = min(distance, max(0., edge - position.lat) * METERS_PER_DEGREE);
+	}
+	if (range.col_from > 0)
+	{
+		const double edge = grid_.min_lng + range.col_from * grid_.cell_lng;
+		distance = min(distance, max(0., position.lng - edge) * lng_meters);
+	}
+	if (range.col_to + 1 < grid_.cols)
+	{
+		const double edge = grid_.min_lng + (range.col_to + 1) * grid_.cell_lng;
+		distance = min(distance, max(0., edge - position.lng) * lng_meters);
+	}
+	return distance;
+}
+
+double Transport::SpatialIndex::DistanceToGrid(Geo::Coordinates position) const
+{
+	const double max_lat = grid_.min_lat + grid_.rows * grid_.cell_lat;
+	const double max_lng = grid_.min_lng + grid_.cols * grid_.cell_lng;
+	const double lat_gap = max({ 0., grid_.min_lat - position.lat, position.lat - max_lat });
+	const double lng_gap = max({ 0., grid_.min_lng - position.lng, position.lng - max_lng });
+	return max(lat_gap * METERS_PER_DEGREE, lng_gap * GetLngMeters(position));
+}
+
+double Transport::SpatialIndex::GetLngMeters(Geo::Coordinates position) const
+{
+	const double max_lat = grid_.min_lat + grid_.rows * grid_.cell_lat;
+	const double max_abs_lat = max({ abs(grid_.min_lat), abs(max_lat), abs(position.lat) });
+	return METERS_PER_DEGREE * cos(min(max_abs_lat, 90.) * DEGREE);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Transport {
+
+	struct NearbyPoint
+	{
+		size_t id = 0;
+		// meters
+		double distance = 0.;
+	};
+
+	// Uniform grid over points on the Earth's surface. Points are grouped by cell,
+	// so a query only looks at the cells around the requested position.
+	// The grid doesn't wrap around the antimeridian, so the points across it are searched
+	// from the position shifted by a turn of longitude.
+	class SpatialIndex
+	{
+	public:
+		struct Grid
+		{
+			double min_lat = 0.;
+			double min_lng = 0.;
+			// cell size in degrees
+			double cell_lat = 1.;
+			double cell_lng = 1.;
+			size_t rows = 0;
+			size_t cols = 0;
+		};
+
+		SpatialIndex() = default;
+
+		// builds the index, points[i] gets id i
+		explicit SpatialIndex(const std::vector<Geo::Coordinates>& points);
+
+		// restores the index from the data returned by the getters below
+		SpatialIndex(Grid grid, std::vector<uint32_t> cell_offsets, std::vector<uint32_t> ids,
+			const std::vector<Geo::Coordinates>& points);
+
+		// points within radius meters from center, nearest first
+		std::vector<NearbyPoint> FindInRadius(Geo::Coordinates center, double radius) const;
+
+		// count nearest points to center, optionally limited by radius meters, nearest first
+		std::vector<NearbyPoint> FindNearest(Geo::Coordinates center, size_t count,
+			std::optional<double> radius = std::nullopt) const;
+
+		// reading for serialization
+		const Grid& GetGrid() const;
+		const std::vector<uint32_t>& GetCellOffsets() const;
+		const std::vector<uint32_t>& GetIds() const;
+
+	private:
+		struct CellRange
+		{
+			size_t row_from = 0;
+			size_t row_to = 0;
+			size_t col_from = 0;
+			size_t col_to = 0;
+		};
+
+		size_t GetRow(double lat) const;
+		size_t GetCol(double lng) const;
+
+		// adds the points within radius from center of the cells around position, which is center
+		// or center shifted by a turn of longitude
+		void CollectInRadius(Geo::Coordinates position, Geo::Coordinates center, double radius,
+			std::vector<NearbyPoint>& result) const;
+
+		// adds the points which may be among count nearest to center searching from position as above
+		void CollectNearest(Geo::Coordinates position, Geo::Coordinates center, size_t count, double max_distance,
+			std::vector<NearbyPoint>& result) const;
+
+		// adds the points of the cells in rows [row_from, row_to] and cols [col_from, col_to] within radius from center
+		void CollectCells(const CellRange& range, Geo::Coordinates center, double radius,
+			std::vector<NearbyPoint>& result) const;
+
+		// lower bound of the distance from position to any cell outside range
+		double DistanceOutside(const CellRange& range, Geo::Coordinates position) const;
+
+		// lower bound of the distance from position to any cell
+		double DistanceToGrid(Geo::Coordinates position) const;
+
+		// meters in a degree of longitude at the latitude of the grid or position farthest from the equator
+		double GetLngMeters(Geo::Coordinates position) const;
+
+	private:
+		Grid grid_;
+		// points of cell (row, col) are points_[cell_offsets_[c]] .. points_[cell_offsets_[c + 1] - 1], c = row * cols + col
+		std::vector<uint32_t> cell_offsets_;
+		std::vector<uint32_t> ids_;
+		std::vector<Geo::Coordinates> points_;
+	};
+}
@@ -0,0 +1,151 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace Transport;
+using namespace std;
+
+namespace {
+	int failures = 0;
+
+	void Check(bool condition, std::string_view what)
+	{
+		if (!condition)
+		{
+			cerr << "FAILED: "sv << what << '\n';
+			++failures;
+		}
+	}
+
+	vector<Geo::Coordinates> MakeGrid(size_t rows, size_t cols)
+	{
+		vector<Geo::Coordinates> points;
+		for (size_t row = 0; row < rows; row++)
+		{
+			for (size_t col = 0; col < cols; col++)
+			{
+				points.push_back({ 55.6 + row * 0.01, 37.5 + col * 0.01 });
+			}
+		}
+		return points;
+	}
+
+	bool IsSorted(const vector<NearbyPoint>& points)
+	{
+		for (size_t i = 1; i < points.size(); i++)
+		{
+			if (points[i].distance < points[i - 1].distance)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// ids of the points within radius from center, or of count nearest ones, by the distance to every point
+	vector<size_t> FindAll(const vector<Geo::Coordinates>& points, Geo::Coordinates center, size_t count, double radius)
+	{
+		vector<pair<double, size_t>> distances;
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			const double distance = Geo::ComputeDistance(center, points[i]);
+			if (distance <= radius)
+			{
+				distances.push_back({ distance, i });
+			}
+		}
+		sort(distances.begin(), distances.end());
+		vector<size_t> ids;
+		for (size_t i = 0; i < distances.size() && i < count; i++)
+		{
+			ids.push_back(distances[i].second);
+		}
+		return ids;
+	}
+
+	vector<size_t> GetIds(const vector<NearbyPoint>& points)
+	{
+		vector<size_t> ids;
+		for (const auto& point : points) {
+			ids.push_back(point.id);
+		}
+		return ids;
+	}
+
+	// more points requested than there are, so the search has to stop at the edge of the grid
+	void TestNearestMoreThanAll()
+	{
+		const SpatialIndex index(MakeGrid(6, 10));
+
+		const auto inside = index.FindNearest({ 55.62, 37.53 }, 1000);
+		Check(inside.size() == 60, "all points are found from inside the grid"sv);
+		Check(IsSorted(inside), "points found from inside the grid are sorted"sv);
+
+		const auto outside = index.FindNearest({ 50., 30. }, 1000);
+		Check(outside.size() == 60, "all points are found from outside the grid"sv);
+		Check(IsSorted(outside), "points found from outside the grid are sorted"sv);
+
+		Check(index.FindNearest({ 55.62, 37.53 }, 1000, 1500.).size() < 60, "radius limits the points"sv);
+	}
+
+	// one axis spans almost nothing, the other the whole globe
+	void TestDegenerateSpan()
+	{
+		const SpatialIndex index({ { 43.0, -179.0 }, { 43.00000000000001, 179.0 } });
+		Check(index.GetCellOffsets().size() <= 3, "a degenerate axis gets no more cells than the points need"sv);
+		Check(index.FindNearest({ 43.0, 0. }, 10).size() == 2, "both points are found in a degenerate grid"sv);
+		Check(index.FindInRadius({ 43.0, -179.0 }, 1.).size() == 1, "the radius search works in a degenerate grid"sv);
+	}
+
+	// points on both sides of the antimeridian are neighbours, though the grid puts them in its opposite columns
+	void TestAntimeridian()
+	{
+		const vector<Geo::Coordinates> points{ { 65., 179.95 }, { 65.01, -179.96 }, { 65., 170. }, { 65.02, -170. } };
+		const SpatialIndex index(points);
+		const Geo::Coordinates center{ 65., 179.99 };
+		Check(GetIds(index.FindInRadius(center, 10000.)) == vector<size_t>{ 0, 1 }, "the radius search wraps around the antimeridian"sv);
+		Check(GetIds(index.FindNearest(center, 2)) == vector<size_t>{ 0, 1 }, "the nearest search wraps around the antimeridian"sv);
+		Check(GetIds(index.FindNearest({ 65., -179.99 }, 3)) == vector<size_t>{ 1, 0, 3 },
+			"the nearest search wraps around the antimeridian westward"sv);
+
+		// random points and queries near the antimeridian against the distance to every point
+		mt19937 generator(42);
+		uniform_real_distribution<double> lat(64.5, 65.5);
+		uniform_real_distribution<double> lng_offset(-2., 2.);
+		const auto wrap = [](double lng) { return lng > 180. ? lng - 360. : lng < -180. ? lng + 360. : lng; };
+		vector<Geo::Coordinates> random_points;
+		for (int i = 0; i < 300; i++)
+		{
+			random_points.push_back({ lat(generator), wrap(180. + lng_offset(generator)) });
+		}
+		const SpatialIndex random_index(random_points);
+		bool radius_ok = true;
+		bool nearest_ok = true;
+		for (int i = 0; i < 200; i++)
+		{
+			const Geo::Coordinates query{ lat(generator), wrap(180. + lng_offset(generator)) };
+			const double radius = 1000. + i * 200.;
+			const size_t count = 1 + i % 12;
+			radius_ok = radius_ok && GetIds(random_index.FindInRadius(query, radius)) == FindAll(random_points, query, random_points.size(), radius);
+			nearest_ok = nearest_ok && GetIds(random_index.FindNearest(query, count)) == FindAll(random_points, query, count, 1e18);
+		}
+		Check(radius_ok, "random radius searches across the antimeridian find every point"sv);
+		Check(nearest_ok, "random nearest searches across the antimeridian find every point"sv);
+	}
+}
+
+int main()
+{
+	TestNearestMoreThanAll();
+	TestDegenerateSpan();
+	TestAntimeridian();
+	if (failures == 0)
+	{
+		cerr << "spatial_index_test OK"sv << '\n';
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include "string_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+using namespace Transport;
+
+Transport::StringArena::StringArena(std::pmr::memory_resource* resource)
+	: resource_(resource), blocks_(resource)
+{
+}
+
+Transport::StringArena::StringArena(StringArena&& other) noexcept
+	: resource_(other.resource_), blocks_(std::move(other.blocks_)),
+	current_(std::exchange(other.current_, nullptr)), free_(std::exchange(other.free_, 0))
+{
+	other.blocks_.clear();
+}
+
+StringArena& Transport::StringArena::operator=(StringArena&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		resource_ = other.resource_;
+		blocks_ = std::pmr::vector<Block>(std::move(other.blocks_), resource_);
+		other.blocks_.clear();
+		current_ = std::exchange(other.current_, nullptr);
+		free_ = std::exchange(other.free_, 0);
+	}
+	return *this;
+}
+
+Transport::StringArena::~StringArena()
+{
+	Release();
+}
+
+std::string_view Transport::StringArena::Store(std::string_view str)
+{
+	if (str.empty())
+	{
+		return {};
+	}
+	if (str.size() > free_)
+	{
+		AddBlock(str.size());
+	}
+	char* data = current_;
+	std::memcpy(data, str.data(), str.size());
+	current_ += str.size();
+	free_ -= str.size();
+	return { data, str.size() };
+}
+
+void Transport::StringArena::AddBlock(size_t min_size)
+{
+	const size_t size = std::max(BLOCK_SIZE, min_size);
+	blocks_.push_back({ static_cast<char*>(resource_->allocate(size, 1)), size });
+	current_ = blocks_.back().data;
+	free_ = size;
+}
+
+void Transport::StringArena::Release()
+{
+	for (const auto& block : blocks_) {
+		resource_->deallocate(block.data, block.size, 1);
+	}
+	blocks_.clear();
+	current_ = nullptr;
+	free_ = 0;
+}
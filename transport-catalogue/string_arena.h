@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace Transport {
+
+	// Owns the names of stops and buses. Strings are packed into large blocks,
+	// so storing a name costs an allocation only when the current block is full.
+	// Returned views stay valid for the lifetime of the arena, even after it is moved.
+	class StringArena
+	{
+	public:
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+		explicit StringArena(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+		StringArena(StringArena&& other) noexcept;
+		StringArena& operator=(StringArena&& other) noexcept;
+		~StringArena();
+
+		// copies str into the arena and returns a view of the stored copy
+		std::string_view Store(std::string_view str);
+
+	private:
+		struct Block
+		{
+			char* data = nullptr;
+			size_t size = 0;
+		};
+
+		void AddBlock(size_t min_size);
+		void Release();
+
+	private:
+		std::pmr::memory_resource* resource_;
+		std::pmr::vector<Block> blocks_;
+		char* current_ = nullptr;
+		size_t free_ = 0;
+	};
+}
@@ -8,9 +8,27 @@
 using namespace Transport;
 using namespace std;
 
+Transport::TransportCatalogue::TransportCatalogue(std::pmr::memory_resource* resource)
+	: resource_(resource),
+	names_(resource),
+	stops_(resource),
+	buses_(resource),
+	stop_name_to_stop_(resource),
+	bus_name_to_bus_(resource),
+	stop_to_buses_{ std::pmr::vector<size_t>(resource), std::pmr::vector<const Bus*>(resource) },
+	buses_by_name_(resource),
+	between_stops_distances_(resource)
+{
+}
+
+std::pmr::memory_resource* Transport::TransportCatalogue::GetMemoryResource() const
+{
+	return resource_;
+}
+
 void Transport::TransportCatalogue::AddStop(std::string_view name, Geo::Coordinates coords)
 {
-	stops_.push_back({ static_cast<string>(name), coords });
+	stops_.push_back({ names_.Store(name), coords, stops_.size() });
 	stop_name_to_stop_[stops_.back().name] = &(stops_.back());
 }
 
@@ -28,32 +46,214 @@ const Transport::TransportCatalogue::DistanceMap& Transport::TransportCatalogue:
 	return between_stops_distances_;
 }
 
-const std::unordered_map<const Stop*, std::set<const Bus*, BusComparator>>& Transport::TransportCatalogue::GetStopsToBuses() const
+void Transport::TransportCatalogue::BuildIndexes()
 {
-	return stop_to_buses_;
+	BuildStopToBuses();
+	BuildNameIndexes();
+	BuildSpatialIndex();
+	BuildSearchIndexes();
 }
 
-void Transport::TransportCatalogue::SetStops(std::deque<Stop> stops)
+const PerfectHash& Transport::TransportCatalogue::GetStopNameIndex() const
 {
-	stops_ = std::move(stops);
+	return stop_name_index_;
+}
+
+const PerfectHash& Transport::TransportCatalogue::GetBusNameIndex() const
+{
+	return bus_name_index_;
+}
+
+const SpatialIndex& Transport::TransportCatalogue::GetSpatialIndex() const
+{
+	return spatial_index_;
+}
+
+const NameSearchIndex& Transport::TransportCatalogue::GetStopSearchIndex() const
+{
+	return stop_search_index_;
+}
+
+const NameSearchIndex& Transport::TransportCatalogue::GetBusSearchIndex() const
+{
+	return bus_search_index_;
+}
+
+std::vector<const Stop*> Transport::TransportCatalogue::SuggestStops(std::string_view query, size_t count, size_t max_errors) const
+{
+	vector<const Stop*> result;
+	for (const auto id : stop_search_index_.FindFuzzy(query, max_errors, count)) {
+		result.push_back(&stops_[id]);
+	}
+	return result;
+}
+
+std::vector<const Bus*> Transport::TransportCatalogue::SuggestBuses(std::string_view query, size_t count, size_t max_errors) const
+{
+	vector<const Bus*> result;
+	for (const auto id : bus_search_index_.FindFuzzy(query, max_errors, count)) {
+		result.push_back(&buses_[id]);
+	}
+	return result;
+}
+
+std::vector<NearbyStop> Transport::TransportCatalogue::FindStopsInRadius(Geo::Coordinates center, double radius) const
+{
+	return ToNearbyStops(spatial_index_.FindInRadius(center, radius));
+}
+
+std::vector<NearbyStop> Transport::TransportCatalogue::FindNearestStops(Geo::Coordinates center, size_t count,
+	std::optional<double> radius) const
+{
+	return ToNearbyStops(spatial_index_.FindNearest(center, count, radius));
+}
+
+std::vector<NearbyStop> Transport::TransportCatalogue::ToNearbyStops(const std::vector<NearbyPoint>& points) const
+{
+	vector<NearbyStop> result;
+	result.reserve(points.size());
+	for (const auto& point : points) {
+		result.push_back({ &stops_[point.id], point.distance });
+	}
+	return result;
+}
+
+void Transport::TransportCatalogue::BuildSpatialIndex()
+{
+	vector<Geo::Coordinates> points;
+	points.reserve(stops_.size());
 	for (const auto& stop : stops_) {
-		stop_name_to_stop_[stop.name] = &stop;
+		points.push_back(stop.coords);
 	}
+	spatial_index_ = SpatialIndex(points);
 }
 
-void Transport::TransportCatalogue::SetBuses(std::deque<Bus> buses)
+void Transport::TransportCatalogue::BuildNameIndexes()
 {
-	buses_ = std::move(buses);
+	vector<string_view> names;
+	names.reserve(stops_.size());
+	for (const auto& stop : stops_) {
+		names.push_back(stop.name);
+	}
+	stop_name_index_ = PerfectHash(names);
+
+	names.clear();
 	for (const auto& bus : buses_) {
-		bus_name_to_bus_[bus.name] = &bus;
+		names.push_back(bus.name);
 	}
+	bus_name_index_ = PerfectHash(names);
+
+	stop_name_to_stop_.clear();
+	bus_name_to_bus_.clear();
 }
 
-void Transport::TransportCatalogue::SetStopToBuses(StopToRoutesMap stop_to_buses)
+void Transport::TransportCatalogue::BuildSearchIndexes()
+{
+	vector<string_view> names;
+	names.reserve(stops_.size());
+	for (const auto& stop : stops_) {
+		names.push_back(stop.name);
+	}
+	stop_search_index_ = NameSearchIndex(names);
+
+	names.clear();
+	for (const auto& bus : buses_) {
+		names.push_back(bus.name);
+	}
+	bus_search_index_ = NameSearchIndex(names);
+}
+
+void Transport::TransportCatalogue::BuildStopToBuses()
+{
+	buses_by_name_.clear();
+	for (const auto& bus : buses_) {
+		buses_by_name_.push_back(&bus);
+	}
+	std::sort(buses_by_name_.begin(), buses_by_name_.end(), BusComparator{});
+
+	// last_bus[stop id] - last bus counted for the stop, so repeated stops of a route are counted once;
+	// buses of the same name are adjacent in name order and counted once too, as the set of them by name did
+	vector<const Bus*> last_bus(stops_.size(), nullptr);
+	const auto is_counted = [&last_bus](const Stop* stop, const Bus* bus) {
+		return last_bus[stop->id] && last_bus[stop->id]->name == bus->name;
+	};
+	std::pmr::vector<size_t> offsets(stops_.size() + 1, 0, resource_);
+	for (const Bus* bus : buses_by_name_) {
+		for (const Stop* stop : bus->stops) {
+			if (!is_counted(stop, bus))
+			{
+				last_bus[stop->id] = bus;
+				++offsets[stop->id + 1];
+			}
+		}
+	}
+	for (size_t i = 0; i < stops_.size(); i++)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	// buses are visited in name order, so every stop range comes out sorted
+	std::pmr::vector<const Bus*> buses(offsets.back(), nullptr, resource_);
+	vector<size_t> positions(offsets.begin(), offsets.end() - 1);
+	std::fill(last_bus.begin(), last_bus.end(), nullptr);
+	for (const Bus* bus : buses_by_name_) {
+		for (const Stop* stop : bus->stops) {
+			if (!is_counted(stop, bus))
+			{
+				last_bus[stop->id] = bus;
+				buses[positions[stop->id]++] = bus;
+			}
+		}
+	}
+
+	stop_to_buses_ = { std::move(offsets), std::move(buses) };
+}
+
+void Transport::TransportCatalogue::SetStops(std::pmr::deque<Stop> stops)
+{
+	stops_ = std::move(stops);
+	for (size_t i = 0; i < stops_.size(); i++)
+	{
+		stops_[i].id = i;
+		stops_[i].name = names_.Store(stops_[i].name);
+	}
+}
+
+void Transport::TransportCatalogue::SetBuses(std::pmr::deque<Bus> buses)
+{
+	buses_ = std::move(buses);
+	buses_by_name_.clear();
+	for (size_t i = 0; i < buses_.size(); i++)
+	{
+		buses_[i].id = i;
+		buses_[i].name = names_.Store(buses_[i].name);
+		buses_by_name_.push_back(&buses_[i]);
+	}
+	std::sort(buses_by_name_.begin(), buses_by_name_.end(), BusComparator{});
+}
+
+void Transport::TransportCatalogue::SetStopToBuses(StopToBusesIndex stop_to_buses)
 {
 	stop_to_buses_ = std::move(stop_to_buses);
 }
 
+void Transport::TransportCatalogue::SetNameIndexes(PerfectHash stop_name_index, PerfectHash bus_name_index)
+{
+	stop_name_index_ = std::move(stop_name_index);
+	bus_name_index_ = std::move(bus_name_index);
+}
+
+void Transport::TransportCatalogue::SetSpatialIndex(SpatialIndex spatial_index)
+{
+	spatial_index_ = std::move(spatial_index);
+}
+
+void Transport::TransportCatalogue::SetSearchIndexes(NameSearchIndex stop_search_index, NameSearchIndex bus_search_index)
+{
+	stop_search_index_ = std::move(stop_search_index);
+	bus_search_index_ = std::move(bus_search_index);
+}
+
 void Transport::TransportCatalogue::SetDistanceMap(DistanceMap distance_map)
 {
 	between_stops_distances_ = std::move(distance_map);
@@ -61,18 +261,21 @@ void Transport::TransportCatalogue::SetDistanceMap(DistanceMap distance_map)
 
 void Transport::TransportCatalogue::AddBus(std::string_view name, const std::vector<const Stop*>& stops, bool is_roundtrip)
 {
-	buses_.push_back({ static_cast<string>(name), stops, is_roundtrip });
+	buses_.push_back({ names_.Store(name), std::pmr::vector<const Stop*>(stops.begin(), stops.end(), resource_), is_roundtrip, buses_.size() });
 	bus_name_to_bus_[buses_.back().name] = &(buses_.back());
-	for (const auto stop_ptr : buses_.back().stops) {
-		stop_to_buses_[stop_ptr].insert(&(buses_.back()));
-	}
 }
 
 const Stop* TransportCatalogue::GetStop(std::string_view stop_name) const
 {
-	if (stop_name_to_stop_.count(stop_name))
+	if (stop_name_index_.GetSize() == 0)
+	{
+		const auto it = stop_name_to_stop_.find(stop_name);
+		return it == stop_name_to_stop_.end() ? nullptr : it->second;
+	}
+	const auto id = stop_name_index_.Find(stop_name);
+	if (id && stops_[*id].name == stop_name)
 	{
-		return stop_name_to_stop_.at(stop_name);
+		return &stops_[*id];
 	}
 	return nullptr;
 }
@@ -99,9 +302,15 @@ int TransportCatalogue::GetRealDistance(const Stop* from, const Stop* to) const
 
 const Bus* TransportCatalogue::GetBus(std::string_view bus_name) const
 {
-	if (bus_name_to_bus_.count(bus_name))
+	if (bus_name_index_.GetSize() == 0)
+	{
+		const auto it = bus_name_to_bus_.find(bus_name);
+		return it == bus_name_to_bus_.end() ? nullptr : it->second;
+	}
+	const auto id = bus_name_index_.Find(bus_name);
+	if (id && buses_[*id].name == bus_name)
 	{
-		return bus_name_to_bus_.at(bus_name);
+		return &buses_[*id];
 	}
 	return nullptr;
 }
@@ -124,11 +333,21 @@ BusInfo TransportCatalogue::GetBusInfo(const Bus* bus_p) const
 	return info;
 }
 
-const std::deque<Bus>& Transport::TransportCatalogue::GetBuses() const
+const std::pmr::deque<Bus>& Transport::TransportCatalogue::GetBuses() const
 {
 	return buses_;
 }
 
+const Stop* Transport::TransportCatalogue::GetStopById(size_t id) const
+{
+	return id < stops_.size() ? &stops_[id] : nullptr;
+}
+
+const Bus* Transport::TransportCatalogue::GetBusById(size_t id) const
+{
+	return id < buses_.size() ? &buses_[id] : nullptr;
+}
+
 const std::vector<const Stop*> Transport::TransportCatalogue::GetStops() const
 {
 	vector<const Stop*> result;
@@ -144,13 +363,19 @@ size_t Transport::TransportCatalogue::GetStopsCount() const
 	return stops_.size();
 }
 
-const std::set<const Bus*, BusComparator> Transport::TransportCatalogue::GetStopToBuses(const Stop* stop) const
+BusesView Transport::TransportCatalogue::GetStopToBuses(const Stop* stop) const
 {
-	if (stop_to_buses_.count(stop))
+	if (!stop || stop->id + 1 >= stop_to_buses_.offsets.size())
 	{
-		return stop_to_buses_.at(stop);
+		return {};
 	}
-	return {};
+	const auto begin = stop_to_buses_.buses.data();
+	return { begin + stop_to_buses_.offsets[stop->id], begin + stop_to_buses_.offsets[stop->id + 1] };
+}
+
+const std::pmr::vector<const Bus*>& Transport::TransportCatalogue::GetBusesByName() const
+{
+	return buses_by_name_;
 }
 
 StopInfo TransportCatalogue::GetStopInfo(const Stop* stop_p) const
@@ -165,13 +390,8 @@ StopInfo TransportCatalogue::GetStopInfo(const Stop* stop_p) const
 	//  ,        
 	info.exists = true;
 
-	if (!stop_to_buses_.count(stop_p))
-	{
-		return info;
-	}
-
 	//       
-	info.buses = &stop_to_buses_.at(stop_p);
+	info.buses = GetStopToBuses(stop_p);
 
 	return info;
 }
@@ -6,10 +6,14 @@
 #include <unordered_map>
 #include <vector>
 #include <iostream>
-#include <set>
+#include <memory_resource>
 
 #include "geo.h"
 #include "domain.h"
+#include "string_arena.h"
+#include "perfect_hash.h"
+#include "spatial_index.h"
+#include "name_search_index.h"
 
 namespace Transport {
 
@@ -24,11 +28,21 @@ namespace Transport {
 			}
 		};
 
-		using DistanceMap = std::unordered_map<std::pair<const Stop*, const Stop*>, int, DistanceMapHasher>;
+		using DistanceMap = std::pmr::unordered_map<std::pair<const Stop*, const Stop*>, int, DistanceMapHasher>;
 
-		using StopToRoutesMap = std::unordered_map<const Stop*, std::set<const Bus*, BusComparator>>;
+		// buses of the stop with id i are buses[offsets[i]] .. buses[offsets[i + 1] - 1], sorted by name
+		struct StopToBusesIndex
+		{
+			std::pmr::vector<size_t> offsets;
+			std::pmr::vector<const Bus*> buses;
+		};
 
 	public:
+		// all containers of the catalogue allocate from resource, which must outlive it
+		explicit TransportCatalogue(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+		std::pmr::memory_resource* GetMemoryResource() const;
+
 		//      
 		const Stop* GetStop(std::string_view stop_name) const;
 
@@ -42,13 +56,34 @@ namespace Transport {
 		//    ,  
 		int GetRealDistance(const Stop* from, const Stop* to) const;
 
-		const std::deque<Bus>& GetBuses() const;
+		const std::pmr::deque<Bus>& GetBuses() const;
+
+		// the stop and the bus with the id, nullptr if there is none
+		const Stop* GetStopById(size_t id) const;
+		const Bus* GetBusById(size_t id) const;
 
 		const std::vector<const Stop*> GetStops() const;
 
 		size_t GetStopsCount() const;
 
-		const std::set<const Bus*, BusComparator> GetStopToBuses(const Stop* stop) const;
+		BusesView GetStopToBuses(const Stop* stop) const;
+
+		// all buses sorted by name
+		const std::pmr::vector<const Bus*>& GetBusesByName() const;
+
+		// stops within radius meters from center, nearest first
+		std::vector<NearbyStop> FindStopsInRadius(Geo::Coordinates center, double radius) const;
+
+		// count nearest stops to center, optionally limited by radius meters, nearest first
+		std::vector<NearbyStop> FindNearestStops(Geo::Coordinates center, size_t count,
+			std::optional<double> radius = std::nullopt) const;
+
+		// at most count stops which names start with query with at most max_errors edits,
+		// fewest errors first, then by name
+		std::vector<const Stop*> SuggestStops(std::string_view query, size_t count, size_t max_errors = 0) const;
+
+		// the same for buses
+		std::vector<const Bus*> SuggestBuses(std::string_view query, size_t count, size_t max_errors = 0) const;
 
 		//     
 		void AddStop(std::string_view name, Geo::Coordinates coords);
@@ -62,19 +97,51 @@ namespace Transport {
 		// reading for serialization
 		const DistanceMap& GetDistanceMap() const;
 
+		// builds the lookup indexes once all stops and buses are added
+		void BuildIndexes();
+
+		// build the indexes of the stops and buses set, for bases written without them
+		void BuildNameIndexes();
+		void BuildSpatialIndex();
+		void BuildSearchIndexes();
+
 		// reading for serialization
-		const StopToRoutesMap& GetStopsToBuses() const;
+		const PerfectHash& GetStopNameIndex() const;
 
-		void SetStops(std::deque<Stop> stops);
+		// reading for serialization
+		const PerfectHash& GetBusNameIndex() const;
 
-		void SetBuses(std::deque<Bus> buses);
+		// reading for serialization
+		const SpatialIndex& GetSpatialIndex() const;
 
-		void SetStopToBuses(StopToRoutesMap stop_to_buses);
+		// reading for serialization
+		const NameSearchIndex& GetStopSearchIndex() const;
+
+		// reading for serialization
+		const NameSearchIndex& GetBusSearchIndex() const;
+
+		// names are copied into the catalogue, so they may refer to temporary storage
+		void SetStops(std::pmr::deque<Stop> stops);
+
+		// names are copied into the catalogue, so they may refer to temporary storage
+		void SetBuses(std::pmr::deque<Bus> buses);
+
+		void SetStopToBuses(StopToBusesIndex stop_to_buses);
+
+		void SetNameIndexes(PerfectHash stop_name_index, PerfectHash bus_name_index);
+
+		void SetSpatialIndex(SpatialIndex spatial_index);
+
+		void SetSearchIndexes(NameSearchIndex stop_search_index, NameSearchIndex bus_search_index);
 
 		void SetDistanceMap(DistanceMap distance_map);
 
 	private:
 
+		void BuildStopToBuses();
+
+		std::vector<NearbyStop> ToNearbyStops(const std::vector<NearbyPoint>& points) const;
+
 		size_t CountUniqueStops(const Bus* bus) const;
 
 		double ComputeBusGeoDistance(const Bus* bus) const;
@@ -83,22 +150,41 @@ namespace Transport {
 
 	private:
 
+		std::pmr::memory_resource* resource_;
+
+		// storage for the names of stops and buses
+		StringArena names_;
+
 		//      
 		// /     
-		std::deque<Stop> stops_;
+		std::pmr::deque<Stop> stops_;
 
 		//       ()
 		// /     
-		std::deque<Bus> buses_;
+		std::pmr::deque<Bus> buses_;
 
 		// -        
-		std::unordered_map<std::string_view, const Stop*> stop_name_to_stop_;
+		std::pmr::unordered_map<std::string_view, const Stop*> stop_name_to_stop_;
 
 		// -        
-		std::unordered_map<std::string_view, const Bus*> bus_name_to_bus_;
+		std::pmr::unordered_map<std::string_view, const Bus*> bus_name_to_bus_;
+
+		// minimal perfect hashes by name, replace the maps above after BuildIndexes() or loading the base
+		PerfectHash stop_name_index_;
+		PerfectHash bus_name_index_;
+
+		// buses passing through each stop (sorted by name), indexed by stop id
+		StopToBusesIndex stop_to_buses_;
+
+		// grid over stop coordinates, point ids are stop ids
+		SpatialIndex spatial_index_;
+
+		// names in sorted order for suggestions
+		NameSearchIndex stop_search_index_;
+		NameSearchIndex bus_search_index_;
 
-		// -   ,    (    )
-		std::unordered_map<const Stop*, std::set<const Bus*, BusComparator>> stop_to_buses_;
+		// buses sorted by name, for rendering and building stop_to_buses_
+		std::pmr::vector<const Bus*> buses_by_name_;
 
 		// -       
 		DistanceMap between_stops_distances_;
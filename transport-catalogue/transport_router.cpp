@@ -1,8 +1,26 @@
 #include "transport_router.h"
 
+#include <stdexcept>
+
+namespace {
+	// stop with id i is represented by the vertices 2 * i (arrival) and 2 * i + 1 (departure)
+	graph::VertexId GetStopVertex(const Transport::TransportCatalogue& catalogue, std::string_view name)
+	{
+		const Transport::Stop* stop = catalogue.GetStop(name);
+		if (!stop)
+		{
+			throw std::out_of_range("Unknown stop");
+		}
+		return stop->id * 2;
+	}
+
+	// the nearest stops a point may be snapped to
+	const size_t SNAPPED_STOPS_COUNT = 16;
+}
+
 std::optional<graph::Router<double>::RouteInfo> Transport::Routing::TransportRouter::BuildRoute(std::string_view from, std::string_view to) const
 {
-	return router_.BuildRoute(vertex_index_.at(catalogue_.GetStop(from)), vertex_index_.at(catalogue_.GetStop(to)));
+	return router_.BuildRoute(GetStopVertex(catalogue_, from), GetStopVertex(catalogue_, to));
 }
 
 Transport::Routing::EdgeInfo Transport::Routing::TransportRouter::GetEdgeInfo(graph::EdgeId id) const
@@ -15,11 +33,27 @@ const Transport::Routing::RouterSettings& Transport::Routing::TransportRouter::G
 	return router_settings_;
 }
 
-const std::vector<Transport::Routing::EdgeInfo>& Transport::Routing::TransportRouter::GetEdgesInfo() const
+const std::pmr::vector<Transport::Routing::EdgeInfo>& Transport::Routing::TransportRouter::GetEdgesInfo() const
 {
 	return edges_info_;
 }
 
+std::vector<Transport::Routing::RouteEdge> Transport::Routing::TransportRouter::GetRouteEdges() const
+{
+	std::vector<RouteEdge> edges;
+	edges.reserve(graph_.GetEdgeCount());
+	for (size_t i = 0; i < graph_.GetEdgeCount(); i++)
+	{
+		const auto& edge = graph_.GetEdge(i);
+		const auto& info = edges_info_[i];
+		// the name is referred to by the id of the stop or the bus
+		const size_t name_id = info.span_count == 0 ? catalogue_.GetStop(info.name)->id : catalogue_.GetBus(info.name)->id;
+		edges.push_back({ info.weight, static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to),
+			static_cast<uint32_t>(info.span_count), static_cast<uint32_t>(name_id) });
+	}
+	return edges;
+}
+
 const graph::DirectedWeightedGraph<double>& Transport::Routing::TransportRouter::GetGraph() const
 {
 	return graph_;
@@ -30,9 +64,9 @@ const graph::Router<double>& Transport::Routing::TransportRouter::GetRouter() co
 	return router_;
 }
 
-graph::DirectedWeightedGraph<double> Transport::Routing::TransportRouter::BuildGraph()
+graph::DirectedWeightedGraph<double> Transport::Routing::TransportRouter::BuildGraph(std::pmr::memory_resource* resource)
 {
-	graph::DirectedWeightedGraph<double> graph(catalogue_.GetStopsCount() * 2);
+	graph::DirectedWeightedGraph<double> graph(catalogue_.GetStopsCount() * 2, resource);
 	AddStops(graph);
 	AddRoutes(graph);
 	return graph;
@@ -104,72 +138,116 @@ void Transport::Routing::TransportRouter::AddRoute(size_t from_index, size_t to_
 				}
 			}
 			prev_weights[route.stops[to]] = weight;
-			graph.AddEdge({ vertex_index_.at(route.stops[from]) + 1, vertex_index_.at(route.stops[to]), weight });
+			graph.AddEdge({ route.stops[from]->id * 2 + 1, route.stops[to]->id * 2, weight });
 			edges_info_.push_back(EdgeInfo{ span_count, route.name, weight });
 		}
 	}
 }
 
-std::unordered_map<const Transport::Stop*, size_t> Transport::Routing::TransportRouter::BuildVertexIndex()
-{
-	const auto stops = catalogue_.GetStops();
-	std::unordered_map<const Transport::Stop*, size_t> index;
-	for (size_t i = 0; i < stops.size(); i++)
-	{
-		index[stops[i]] = i * 2;
-	}
-	return index;
-}
-
 double Transport::Routing::TransportRouter::CalculateWeight(double distance) const
 {
 	double real_time_to_duration = 1000. / 60;
 	return distance / router_settings_.bus_velocity / real_time_to_duration;
 }
 
-Transport::Routing::LightTransportRouter::LightTransportRouter(const TransportCatalogue& catalogue, const std::vector<EdgeInfo>& edges_info, const std::vector<graph::Edge<double>>& edges, const graph::Router<double>::RoutesInternalData& routes_internal_data)
+Transport::Routing::LightTransportRouter::LightTransportRouter(const TransportCatalogue& catalogue, RouterSettings settings, FlatArray<RouteEdge> edges, RouteMatrix routes,
+	std::shared_ptr<const MappedFile> base_file)
 	: catalogue_(catalogue),
-	edges_info_(edges_info),
-	edges_(edges),
-	routes_internal_data_(routes_internal_data),
-	vertex_index_(std::move(BuildVertexIndex()))
+	router_settings_(settings),
+	edges_(std::move(edges)),
+	routes_(std::move(routes)),
+	base_file_(std::move(base_file))
 {
 }
 
 std::optional<graph::Router<double>::RouteInfo> Transport::Routing::LightTransportRouter::BuildRoute(std::string_view from_name, std::string_view to_name) const
 {
-	auto from = vertex_index_.at(catalogue_.GetStop(from_name));
-	auto to = vertex_index_.at(catalogue_.GetStop(to_name));
+	return BuildRoute(GetStopVertex(catalogue_, from_name), GetStopVertex(catalogue_, to_name));
+}
+
+std::optional<Transport::Routing::PointsRouteInfo> Transport::Routing::LightTransportRouter::BuildRoute(Geo::Coordinates from, Geo::Coordinates to) const
+{
+	std::optional<PointsRouteInfo> best;
 
-	const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-	if (!route_internal_data) {
+	const double direct_distance = Geo::ComputeDistance(from, to);
+	if (direct_distance <= router_settings_.walking_distance)
+	{
+		best.emplace();
+		best->weight = CalculateWalkTime(direct_distance);
+		best->walk_to_time = best->weight;
+	}
+
+	// all the routes between the stops are precomputed, so one pass over the pairs of snapped stops
+	// gives the result of a search from all the sources to all the targets at once
+	const auto from_stops = catalogue_.FindNearestStops(from, SNAPPED_STOPS_COUNT, router_settings_.walking_distance);
+	const auto to_stops = catalogue_.FindNearestStops(to, SNAPPED_STOPS_COUNT, router_settings_.walking_distance);
+	const NearbyStop* best_from = nullptr;
+	const NearbyStop* best_to = nullptr;
+	for (const auto& from_stop : from_stops) {
+		const double walk_to_time = CalculateWalkTime(from_stop.distance);
+		const auto routes_from = routes_.GetRow(from_stop.stop->id * 2);
+		for (const auto& to_stop : to_stops) {
+			const auto& route = routes_from[to_stop.stop->id * 2];
+			if (!route.HasRoute())
+			{
+				continue;
+			}
+			const double weight = walk_to_time + route.weight + CalculateWalkTime(to_stop.distance);
+			if (!best || weight < best->weight)
+			{
+				best.emplace();
+				best->weight = weight;
+				best_from = &from_stop;
+				best_to = &to_stop;
+			}
+		}
+	}
+
+	if (best_from)
+	{
+		best->first_stop = best_from->stop;
+		best->last_stop = best_to->stop;
+		best->walk_to_time = CalculateWalkTime(best_from->distance);
+		best->walk_from_time = CalculateWalkTime(best_to->distance);
+		best->edges = BuildRoute(best_from->stop->id * 2, best_to->stop->id * 2)->edges;
+	}
+	return best;
+}
+
+std::optional<graph::Router<double>::RouteInfo> Transport::Routing::LightTransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to) const
+{
+	const auto& route = routes_.Get(from, to);
+	if (!route.HasRoute()) {
 		return std::nullopt;
 	}
-	const auto weight = route_internal_data->weight;
 	std::vector<graph::EdgeId> edges;
-	for (std::optional<graph::EdgeId> edge_id = route_internal_data->prev_edge;
-		edge_id;
-		edge_id = routes_internal_data_[from][edges_.at(*edge_id).from]->prev_edge)
+	for (uint32_t edge_id = route.prev_edge;
+		edge_id != RouteMatrix::NO_EDGE;
+		edge_id = routes_.Get(from, edges_.at(edge_id).from).prev_edge)
 	{
-		edges.push_back(*edge_id);
+		// a route visits a vertex once, a longer one comes from a malformed base
+		if (edges.size() == routes_.GetVertexCount())
+		{
+			throw std::invalid_argument("Routes of the matrix make a cycle");
+		}
+		edges.push_back(edge_id);
 	}
 	std::reverse(edges.begin(), edges.end());
 
-	return graph::Router<double>::RouteInfo{ weight, std::move(edges) };
+	return graph::Router<double>::RouteInfo{ route.weight, std::move(edges) };
 }
 
 Transport::Routing::EdgeInfo Transport::Routing::LightTransportRouter::GetEdgeInfo(graph::EdgeId id) const
 {
-	return edges_info_.at(id);
+	const auto& edge = edges_.at(id);
+	const std::string_view name = edge.span_count == 0
+		? catalogue_.GetStopById(edge.name_id)->name
+		: catalogue_.GetBusById(edge.name_id)->name;
+	return { edge.span_count, name, edge.weight };
 }
 
-std::unordered_map<const Transport::Stop*, size_t> Transport::Routing::LightTransportRouter::BuildVertexIndex()
+double Transport::Routing::LightTransportRouter::CalculateWalkTime(double distance) const
 {
-	const auto stops = catalogue_.GetStops();
-	std::unordered_map<const Transport::Stop*, size_t> index;
-	for (size_t i = 0; i < stops.size(); i++)
-	{
-		index[stops[i]] = i * 2;
-	}
-	return index;
+	double real_time_to_duration = 1000. / 60;
+	return distance / router_settings_.walking_velocity / real_time_to_duration;
 }
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <utility>
+#include <vector>
 #include "transport_catalogue.h"
 #include "router.h"
-
-#include "serialization.h"
+#include "flat_array.h"
+#include "mapped_file.h"
+#include "route_matrix.h"
 
 namespace Transport {
 	namespace Routing {
@@ -14,26 +20,46 @@ namespace Transport {
 
 			//  ,  /.      1  1000
 			int bus_velocity = 40;
+
+			// walking speed for routes between coordinates, km/h
+			double walking_velocity = 5;
+
+			// longest walk to the first stop or from the last stop, meters
+			double walking_distance = 1000;
 		};
 
 		struct EdgeInfo
 		{
 			size_t span_count = 0;
-			std::string name;
+			// stop name for wait edges, bus name otherwise; owned by the catalogue
+			std::string_view name;
+			double weight = 0;
+		};
+
+		// route between two points: walk to first_stop, ride edges, walk from last_stop to the destination.
+		// Without stops the whole route is walked and the walk time is in walk_to_time.
+		struct PointsRouteInfo
+		{
 			double weight = 0;
+			const Stop* first_stop = nullptr;
+			const Stop* last_stop = nullptr;
+			double walk_to_time = 0;
+			double walk_from_time = 0;
+			std::vector<graph::EdgeId> edges;
 		};
 
 		class TransportRouter {
 			//friend void serialization::SerializeTransportRouter(const TransportRouter&, tc_serialization::TransportRouter&);
 
 		public:
-			TransportRouter(const Transport::TransportCatalogue& catalogue, RouterSettings settings)
+			// all containers of the router allocate from resource, which must outlive it
+			TransportRouter(const Transport::TransportCatalogue& catalogue, RouterSettings settings,
+				std::pmr::memory_resource* resource = std::pmr::get_default_resource())
 			  : catalogue_(catalogue),
 				router_settings_(settings),
-				vertex_index_(std::move(BuildVertexIndex())),
-				edges_info_(),
-				graph_(BuildGraph()),
-				router_(graph_) {}
+				edges_info_(resource),
+				graph_(BuildGraph(resource)),
+				router_(graph_, resource) {}
 
 			//   ,      
 			std::optional<graph::Router<double>::RouteInfo> BuildRoute(std::string_view from, std::string_view to) const;
@@ -42,7 +68,9 @@ namespace Transport {
 			EdgeInfo GetEdgeInfo(graph::EdgeId id) const;
 			
 			const RouterSettings& GetRouterSettings() const;
-			const std::vector<EdgeInfo>& GetEdgesInfo() const;
+			const std::pmr::vector<EdgeInfo>& GetEdgesInfo() const;
+			// the edges with their info as the light router keeps them
+			std::vector<RouteEdge> GetRouteEdges() const;
 			const graph::DirectedWeightedGraph<double>& GetGraph() const;
 			const graph::Router<double>& GetRouter() const;
 
@@ -51,24 +79,19 @@ namespace Transport {
 			double CalculateWeight(double distance) const;
 
 			//      catalogue_
-			graph::DirectedWeightedGraph<double> BuildGraph();
+			graph::DirectedWeightedGraph<double> BuildGraph(std::pmr::memory_resource* resource);
 			void AddStops(graph::DirectedWeightedGraph<double>& graph);
 			void AddRoutes(graph::DirectedWeightedGraph<double>& graph);
 			void AddRoute(size_t from_index, size_t to_index, const Transport::Bus& route, graph::DirectedWeightedGraph<double>& graph);
 
-			std::unordered_map<const Stop*, size_t> BuildVertexIndex();
-
 		private:
 			const Transport::TransportCatalogue& catalogue_;
 
 			//  
 			RouterSettings router_settings_;
 
-			// ,          (  )
-			std::unordered_map<const Stop*, size_t> vertex_index_;
-
 			//     
-			std::vector<EdgeInfo> edges_info_;
+			std::pmr::vector<EdgeInfo> edges_info_;
 
 			graph::DirectedWeightedGraph<double> graph_;
 
@@ -81,33 +104,40 @@ namespace Transport {
 		public:
 			LightTransportRouter() = default;
 
+			// edges and routes may refer to base_file, which is kept mapped while the router is alive
 			LightTransportRouter(const TransportCatalogue& catalogue,
-				const std::vector<EdgeInfo>& edges_info,
-				const std::vector<graph::Edge<double>>& edges,
-				const graph::Router<double>::RoutesInternalData& routes_internal_data);
+				RouterSettings settings,
+				FlatArray<RouteEdge> edges,
+				RouteMatrix routes,
+				std::shared_ptr<const MappedFile> base_file = nullptr);
 
 			//   ,      
 			std::optional<graph::Router<double>::RouteInfo> BuildRoute(std::string_view from, std::string_view to) const;
 
+			// fastest route between two points over the stops within walking distance of each of them,
+			// nullopt if neither a ride nor a walk fits into the walking distance
+			std::optional<PointsRouteInfo> BuildRoute(Geo::Coordinates from, Geo::Coordinates to) const;
+
 			EdgeInfo GetEdgeInfo(graph::EdgeId id) const;
 
 		private:
-			std::unordered_map<const Stop*, size_t> BuildVertexIndex();
+			std::optional<graph::Router<double>::RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const;
+
+			double CalculateWalkTime(double distance) const;
 
 		private:
 			const TransportCatalogue& catalogue_;
 
-			//     
-			std::vector<EdgeInfo> edges_info_;
+			RouterSettings router_settings_;
 
-			//  
-			std::vector<graph::Edge<double>> edges_;
+			// edges with the names of their stops and buses
+			FlatArray<RouteEdge> edges_;
 
-			//    
-			graph::Router<double>::RoutesInternalData routes_internal_data_;
-			
-			// ,          (  )
-			std::unordered_map<const Stop*, size_t> vertex_index_;
+			// shortest routes between all the vertices
+			RouteMatrix routes_;
+
+			// the mapped base the edges and the routes may be stored in
+			std::shared_ptr<const MappedFile> base_file_;
 		};
 	}
 }
\ No newline at end of file